@@ -6,6 +6,7 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 namespace hybriddd {
 
@@ -13,27 +14,52 @@ class MyEval {
 private:
 	Timer timer;
 	
-	double time;		
-	DdStructure< 2 > dd, ndd;
+	double time;			// construction
+	double reduce_time;		// reduction
+	DdStructure< 2 > dd, ndd;	// ndd is kept only on request
+	size_t ndd_size;
+	std::vector< size_t > ndd_widths;	// [level] -> nodes before reduction
 	std::string enumerate_type;
 	
 public:
-	MyEval() {}
+	MyEval() : time(0), reduce_time(0), ndd_size(0) {}
 	
 	void setTimer() { timer = Timer(); }
 	void endTimer() { time = timer.curTime(); }
+	void endReduceTimer() { reduce_time = timer.curTime() - time; }
 	
 	void setEnumerateType(std::string type) { enumerate_type = type; }
-	void setNDd(DdStructure< 2 >& ndd_) { ndd = ndd_; }
-	void setDd(DdStructure< 2 >& dd_) { dd = dd_; }
+	
+	// records the statistics of the unreduced diagram; unless keep is set,
+	// the diagram itself is not retained, so that the reduction that follows
+	// can work on it in place instead of on a copy
+	void setNDd(DdStructure< 2 >& ndd_, bool keep = false) {
+		ndd_size = ndd_.size();
+		NodeTableEntity< 2 > const& table = *ndd_.getDiagram();
+		ndd_widths.assign(table.numRows(), 0);
+		for (int i = 0; i < table.numRows(); ++i) ndd_widths[i] = table[i].size();
+		ndd = keep ? ndd_ : DdStructure< 2 >();
+	}
+	void setDd(DdStructure< 2 >& dd_, bool compact = false) {
+		if (compact) dd_.compact();
+		dd = dd_;
+	}
 	
 public:
 	double getTime(int digit = 2) const {
 		return time;
 	}
 	
+	double getReduceTime() const {
+		return reduce_time;
+	}
+	
 	size_t getNonReducedDdSize() const {
-		return ndd.size();
+		return ndd_size;
+	}
+	
+	std::vector< size_t > const& getNonReducedWidths() const {
+		return ndd_widths;
 	}
 	
 	size_t getReducedDdSize() const {
@@ -48,12 +74,14 @@ public:
 		return enumerate_type;
 	}
 	
+	// empty unless the unreduced diagram was kept
 	DdStructure< 2 > getNDd() const { return ndd; }
 	DdStructure< 2 > getDd() const { return dd; }
 	
 	void dump(std::ostream& os) const {
 		os << "# enumerate type : " << getEnumerateType() << endl;	
 		os << "# time : " << setprecision(2) << setiosflags(ios::fixed) << getTime() << endl;
+		os << "# reduce time : " << getReduceTime() << endl;
 		os << "# non reduced dd size : " << getNonReducedDdSize() << endl;
 		os << "# reduced dd size : " << getReducedDdSize() << endl;
 		os << "# cardinality : " << getCardinality() << endl;
@@ -1,6 +1,8 @@
 #ifndef MY_TD_ZDD_HPP
 #define MY_TD_ZDD_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <string>
 #include <sstream>
@@ -16,33 +18,63 @@ private:
 	MessageHandler mh;
 	DdStructure< 2 > dd;
 	bool vvar;
+	bool use_blocks;
+	bool keep_ndd;
+	bool compact_dd;
+	bool async_build;
+	std::string var_order;
+	size_t beam_width;
+	double beam_time_limit;
 	
 public:
-	MyTdZdd() {}
+	MyTdZdd() : vvar(false), use_blocks(false), keep_ndd(false), compact_dd(false),
+				async_build(false), var_order("bfs"), beam_width(16), beam_time_limit(0) {}
 	
-	MyTdZdd(std::string file_name, std::string var_order = "bfs") {
-		inputGraph(file_name, var_order);
+	MyTdZdd(std::string file_name, std::string var_order = "bfs",
+			std::string cache_dir = "") : use_blocks(false), keep_ndd(false), compact_dd(false),
+										  async_build(false), beam_width(16), beam_time_limit(0) {
+		inputGraph(file_name, var_order, cache_dir);
 	}
 	
-	void inputGraph(std::string file_name, std::string var_order) {
-		std::ifstream ifs(file_name.c_str());
-		if (ifs.fail()) fopen_err(file_name);
-		
-		int V, E;
-		ifs >> V >> E;
-		
-		graph = HybridGraph(V);
+	// parameters of the "beam" ordering (see Graph::setBeamSearch), used by
+	// the next inputGraph / reordering
+	void setBeamSearch(size_t width, double time_limit = 0) {
+		beam_width = std::max(width, size_t(1));
+		beam_time_limit = time_limit;
+		graph.setBeamSearch(beam_width, beam_time_limit);
+	}
+	
+	// with a cache_dir, the ordered graph is loaded from / saved to a binary
+	// image keyed by the content of file_name and var_order
+	void inputGraph(std::string file_name, std::string var_order,
+					std::string cache_dir = "") {
+		this->var_order = var_order;
+		uint64_t hash = 0;
+		std::string cache_file;
+		
+		std::string key = GraphCache::key(var_order, beam_width, beam_time_limit);
+		
+		if (!cache_dir.empty()) {
+			hash = EdgeListFile::contentHash(file_name);
+			cache_file = GraphCache::path(cache_dir, hash, key);
+		}
 		
-		for (int i = 0; i < E; ++i) {
-			int u, v;
-			ifs >> u >> v;
-			graph.addEdge(u, v);
+		if (cache_file.empty() || !GraphCache::load(graph, cache_file, hash, key)) {
+			EdgeListFile elf(file_name);
+			
+			graph = HybridGraph(elf.getNumOfV());
+			graph.addEdges(elf.getEdges());
+			graph.setBeamSearch(beam_width, beam_time_limit);
+			
+			graph.setOrder(var_order);
+			graph.setItems();
+			
+			if (!cache_file.empty() && !GraphCache::save(graph, cache_file, hash, key))
+				mh << "cannot write graph cache [" << cache_file << "]\n";
 		}
+		graph.setBeamSearch(beam_width, beam_time_limit);
 		
-		ifs.close();
-		
-		graph.setOrder(var_order);
-		graph.setItems();
+		reportFrontier(var_order);
 		
 		vvar = false;
 	}
@@ -55,13 +87,149 @@ public:
 	}
 	
 	void reordering(std::string var_order) {
+		this->var_order = var_order;
 		graph.setOrder(var_order);
 		graph.setItems();
+		reportFrontier(var_order);
+	}
+	
+	// frontier width of the current order, known before any DD is built
+	void reportFrontier(std::string var_order) {
+		mh << "order " << var_order << ": frontier max " << graph.getMaxFSize()
+		   << ", mean " << graph.getMeanFSize() << "\n";
+	}
+	
+	// calls f(T()) with the narrowest signed type T that holds the vertex ids
+	// and the component ids (< F + 2) of g; the mate specs take it as width
+	template < class F >
+	static void withMateWidth(const Graph& g, F f) {
+		size_t w = std::max(g.getNumOfV(), g.getMaxFSize() + 2);
+		if (w <= INT8_MAX) f(int8_t());
+		else if (w <= INT16_MAX) f(int16_t());
+		else f(int32_t());
+	}
+	
+	// like withMateWidth for the specs that also take packed mates: the
+	// flags -2, -1 and component ids up to max_id fit in 4 or 6 bits for
+	// frontiers of up to 31 items (10 or 16 mates per word)
+	template < class F >
+	static void withPackedMates(const Graph& g, size_t max_id, F f) {
+		if (max_id <= 7) f(tdzdd::PackedBits< 4 >());
+		else if (max_id <= 31) f(tdzdd::PackedBits< 6 >());
+		else withMateWidth(g, f);
+	}
+	
+private:
+	// compiles build(bg) on the union of blocks and lifts it to the items of
+	// graph into dd. false if the vertex items of the union don't follow the
+	// order of graph; dd is not touched then
+	template < class BUILD >
+	bool buildOnBlocks(const Vec< Vec< Graph::pii > >& blocks, bool vertex_var,
+					   BUILD build) {
+		BlockGraph bg(graph, blocks);
+		const HybridGraph& sub = bg.getSub();
+		
+		if (vertex_var && !bg.liftsHV()) {
+			mh << "blocks don't lift to the order " << var_order << ", compiling the whole graph\n";
+			return false;
+		}
+		
+		mh << blocks.size() << " blocks, " << sub.getNumOfV() << " vertices, "
+		   << sub.getNumOfE() << " edges, frontier max " << sub.getMaxFSize() << "\n";
+		
+		DdStructure< 2 > sub_dd = build(bg);
+		
+		const Vec< int >& map = vertex_var ? bg.getLevelMapHV() : bg.getLevelMap();
+		dd = DdStructure< 2 >(levelMapped(sub_dd, map));
+		return true;
+	}
+	
+public:
+	// builds make(g) under several orderings in parallel and keeps the one
+	// with the smallest reduced ZDD. a candidate is cut off once it expands
+	// more than node_budget nodes (0: no limit), more than the best finished
+	// candidate, or runs longer than time_budget seconds (0: no limit).
+	// returns the chosen ordering ("beam#k" are seeded beam restarts), or ""
+	// if every candidate ran out of budget and the order was left unchanged
+	template < class MAKER >
+	std::string autoOrder(MAKER make, size_t node_budget = 0,
+						  double time_budget = 0, int restarts = 4) {
+		Vec< std::string > names = {"bfs", "dfs", "greedy", "beam"};
+		for (int r = 1; r <= restarts; ++r) names.push_back("beam#" + std::to_string(r));
+		
+		int n = names.size();
+		Vec< size_t > sizes(n, 0);
+		Vec< char > done(n, false);
+		std::atomic< size_t > bound(node_budget > 0 ? node_budget : SIZE_MAX);
+		
+		bool shown = MessageHandler::showMessages(false);
+		
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int c = 0; c < n; ++c) {
+			HybridGraph g(graph);
+			g.setOrder(names[c]);
+			g.setItems();
+			
+			DdBudget budget(&bound, time_budget);
+			DdStructure< 2 > d(budgeted(make(g), budget));
+			if (budget.isExceeded()) continue;
+			
+			// later candidates must not expand more than this one did
+			size_t b = bound.load();
+			while (budget.getNodes() < b &&
+				   !bound.compare_exchange_weak(b, budget.getNodes())) {}
+			
+			d.zddReduce();
+			sizes[c] = d.size();
+			done[c] = true;
+		}
+		
+		MessageHandler::showMessages(shown);
+		
+		int best = -1;
+		for (int c = 0; c < n; ++c) {
+			if (!done[c]) continue;
+			mh << names[c] << ": " << sizes[c] << " nodes\n";
+			if (best < 0 || sizes[c] < sizes[best]) best = c;
+		}
+		
+		if (best < 0) {
+			mh << "every ordering ran out of budget\n";
+			return "";
+		}
+		
+		reordering(names[best]);
+		vvar = false;
+		return names[best];
 	}
 	
 	const HybridGraph& getGraph() const { return graph; }
 	bool isVVar() const { return vvar; }
 	
+	// Cycle() and S_T_Path() compile only the biconnected blocks that can
+	// hold the answer, in the current order of the graph
+	void setBlockDecomposition(bool flag = true) { use_blocks = flag; }
+	
+	// MyEval::getNDd() returns the unreduced diagram only with this flag;
+	// keeping it doubles the memory of the reduction
+	void keepNonReducedDd(bool flag = true) { keep_ndd = flag; }
+	
+	// the reduced diagram is stored with 32-bit branches (half the memory);
+	// evaluation and export read it as is, other operations expand it
+	void compactResult(bool flag = true) { compact_dd = flag; }
+	
+	// Connected() with vertex variables is built without level barriers
+	// (DdStructure::constructAsync), which pays off only on many threads
+	void useAsyncBuild(bool flag = true) { async_build = flag; }
+	
+	// node rows of 1MB or more are kept in unlinked files in dir, which the
+	// kernel can write out; an empty dir keeps them in memory
+	void setScratchDirectory(std::string dir) { MappedStorage::setDirectory(dir); }
+
+	// work blocks of the builders grow up to maxBytes; with hugePages, blocks
+	// of 2MB or more ask the kernel for transparent huge pages
+	void setWorkBlocks(size_t maxBytes, bool hugePages = false) { BlockAllocator::configure(maxBytes, hugePages); }
+	
 public:
 	void setShowMessages() { MessageHandler::showMessages(); }
 	
@@ -80,11 +248,12 @@ public:
 		dd = DdStructure< 2 >(power);
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -109,20 +278,41 @@ public:
 		
 		mh.begin(result.getEnumerateType().c_str());
 		
-		if (vertex_var) {
-			PAC_HV pac(graph, s, t);
-			dd = DdStructure< 2 >(pac);
-		} else {
-			PAC pac(graph, s, t);
-			dd = DdStructure< 2 >(pac);
+		Vec< Vec< Graph::pii > > blocks;
+		if (use_blocks && s != t) {
+			blocks = BlockGraph::pathBlocks(graph.getBlocks(), graph.getNumOfV(), s, t);
+		}
+		
+		if (blocks.empty() || !buildOnBlocks(blocks, vertex_var, [&](const BlockGraph& bg) {
+				const HybridGraph& sub = bg.getSub();
+				int ls = bg.getLocal(s), lt = bg.getLocal(t);
+				DdStructure< 2 > res;
+				withMateWidth(sub, [&](auto w) {
+					typedef decltype(w) T;
+					if (vertex_var) res = DdStructure< 2 >(PAC_HV< T >(sub, ls, lt));
+					else res = DdStructure< 2 >(PAC< T >(sub, ls, lt));
+				});
+				return res;
+			})) {
+			withMateWidth(graph, [&](auto w) {
+				typedef decltype(w) T;
+				if (vertex_var) {
+					PAC_HV< T > pac(graph, s, t);
+					dd = DdStructure< 2 >(pac);
+				} else {
+					PAC< T > pac(graph, s, t);
+					dd = DdStructure< 2 >(pac);
+				}
+			});
 		}
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -138,20 +328,38 @@ public:
 		
 		mh.begin(result.getEnumerateType().c_str());
 		
-		if (vertex_var) {
-			PAC_HV pac(graph);
-			dd = DdStructure< 2 >(pac);
-		} else {
-			PAC pac(graph);
-			dd = DdStructure< 2 >(pac);
+		Vec< Vec< Graph::pii > > blocks;
+		if (use_blocks) blocks = BlockGraph::cyclicBlocks(graph.getBlocks());
+		
+		if (blocks.empty() || !buildOnBlocks(blocks, vertex_var, [&](const BlockGraph& bg) {
+				const HybridGraph& sub = bg.getSub();
+				DdStructure< 2 > res;
+				withMateWidth(sub, [&](auto w) {
+					typedef decltype(w) T;
+					if (vertex_var) res = DdStructure< 2 >(PAC_HV< T >(sub));
+					else res = DdStructure< 2 >(PAC< T >(sub));
+				});
+				return res;
+			})) {
+			withMateWidth(graph, [&](auto w) {
+				typedef decltype(w) T;
+				if (vertex_var) {
+					PAC_HV< T > pac(graph);
+					dd = DdStructure< 2 >(pac);
+				} else {
+					PAC< T > pac(graph);
+					dd = DdStructure< 2 >(pac);
+				}
+			});
 		}
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -168,20 +376,29 @@ public:
 		
 		mh.begin(result.getEnumerateType().c_str());
 		
-		if (vertex_var) {
-			CCS_HV ccs(graph, "connected", cc_constraint);
-			dd = DdStructure< 2 >(ccs, true);
-		} else {
-			CCS ccs(graph, "connected", cc_constraint);
-			dd = DdStructure< 2 >(ccs);
-		}
+		withMateWidth(graph, [&](auto w) {
+			typedef decltype(w) T;
+			if (vertex_var) {
+				CCS_HV< T > ccs(graph, "connected", cc_constraint);
+				if (async_build) {
+					dd = DdStructure< 2 >();
+					dd.constructAsync(ccs); // |V| + |E| levels, mostly narrow
+				} else {
+					dd = DdStructure< 2 >(ccs, true);
+				}
+			} else {
+				CCS< T > ccs(graph, "connected", cc_constraint);
+				dd = DdStructure< 2 >(ccs);
+			}
+		});
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -200,20 +417,24 @@ public:
 		
 		mh.begin(result.getEnumerateType().c_str());
 		
-		if (vertex_var) {
-			CCS_HV ccs(graph, "forest", cc_constraint, terminals);
-			dd = DdStructure< 2 >(ccs);
-		} else {
-			CCS ccs(graph, "forest", cc_constraint, terminals);
-			dd = DdStructure< 2 >(ccs);
-		}
+		withMateWidth(graph, [&](auto w) {
+			typedef decltype(w) T;
+			if (vertex_var) {
+				CCS_HV< T > ccs(graph, "forest", cc_constraint, terminals);
+				dd = DdStructure< 2 >(ccs);
+			} else {
+				CCS< T > ccs(graph, "forest", cc_constraint, terminals);
+				dd = DdStructure< 2 >(ccs);
+			}
+		});
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -231,20 +452,24 @@ public:
 		
 		mh.begin(result.getEnumerateType().c_str());
 		
-		if (vertex_var) {
-			CCS_HV ccs(graph, "tree", IntSubset(), terminals);
-			dd = DdStructure< 2 >(ccs);
-		} else {
-			CCS ccs(graph, "tree", IntSubset(), terminals);
-			dd = DdStructure< 2 >(ccs);
-		}
+		withMateWidth(graph, [&](auto w) {
+			typedef decltype(w) T;
+			if (vertex_var) {
+				CCS_HV< T > ccs(graph, "tree", IntSubset(), terminals);
+				dd = DdStructure< 2 >(ccs);
+			} else {
+				CCS< T > ccs(graph, "tree", IntSubset(), terminals);
+				dd = DdStructure< 2 >(ccs);
+			}
+		});
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -262,7 +487,8 @@ public:
 		mh.begin(result.getEnumerateType().c_str());
 		
 		if (vertex_var) {
-			VIG_HV vig(graph, "normal", no_isolate);
+			// only the flags -2, -1 and 0 (in)
+			VIG_HV< tdzdd::PackedBits< 2 > > vig(graph, "normal", no_isolate);
 			dd = DdStructure< 2 >(vig);
 		} else {
 			VIG vig(graph, "normal");
@@ -270,11 +496,12 @@ public:
 		}
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -292,19 +519,22 @@ public:
 		mh.begin(result.getEnumerateType().c_str());
 		
 		if (vertex_var) {
-			VIG_HV vig(graph, "connected", no_isolate);
-			dd = DdStructure< 2 >(vig);
+			withPackedMates(graph, graph.getMaxFSize(), [&](auto w) {
+				VIG_HV< decltype(w) > vig(graph, "connected", no_isolate);
+				dd = DdStructure< 2 >(vig);
+			});
 		} else {
 			VIG vig(graph, "connected");
 			dd = DdStructure< 2 >(vig);
 		}
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -323,19 +553,22 @@ public:
 		mh.begin(result.getEnumerateType().c_str());
 		
 		if (vertex_var) {
-			VIG_HV vig(graph, "forest", no_isolate, cc_constraint);
-			dd = DdStructure< 2 >(vig);
+			withPackedMates(graph, graph.getMaxFSize(), [&](auto w) {
+				VIG_HV< decltype(w) > vig(graph, "forest", no_isolate, cc_constraint);
+				dd = DdStructure< 2 >(vig);
+			});
 		} else {
 			VIG vig(graph, "forest", cc_constraint);
 			dd = DdStructure< 2 >(vig);
 		}
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -353,19 +586,22 @@ public:
 		mh.begin(result.getEnumerateType().c_str());
 		
 		if (vertex_var) {
-			VIG_HV vig(graph, "tree", no_isolate);
-			dd = DdStructure< 2 >(vig);
+			withPackedMates(graph, graph.getMaxFSize(), [&](auto w) {
+				VIG_HV< decltype(w) > vig(graph, "tree", no_isolate);
+				dd = DdStructure< 2 >(vig);
+			});
 		} else {
 			VIG vig(graph, "tree");
 			dd = DdStructure< 2 >(vig);
 		}
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -381,15 +617,18 @@ public:
 		
 		mh.begin(result.getEnumerateType().c_str());
 		
-		VCUT_HV vcut(graph, cc_constraint);
-		dd = DdStructure< 2 >(vcut);
+		withMateWidth(graph, [&](auto w) {
+			VCUT_HV< decltype(w) > vcut(graph, cc_constraint);
+			dd = DdStructure< 2 >(vcut);
+		});
 		
 		result.endTimer();
-		result.setNDd(dd);
+		result.setNDd(dd, keep_ndd);
 		
 		dd.zddReduce();
 		
-		result.setDd(dd);
+		result.endReduceTimer();
+		result.setDd(dd, compact_dd);
 		
 		mh.end("finish");
 		
@@ -440,8 +679,11 @@ public:
 					<< " -> " << targetCustomer << "..." << std::endl;
 			
 			// 构造 s-t 路径的 ZDD
-			PAC_HV pac(graph, sourceVertex, targetCustomer);
-			DdStructure<2> pathZdd(pac);
+			DdStructure<2> pathZdd;
+			withMateWidth(graph, [&](auto w) {
+				PAC_HV< decltype(w) > pac(graph, sourceVertex, targetCustomer);
+				pathZdd = DdStructure<2>(pac);
+			});
 			pathZdd.zddReduce();
 			
 			std::cout << "  ZDD size: " << pathZdd.size() << std::endl;
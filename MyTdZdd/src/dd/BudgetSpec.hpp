@@ -0,0 +1,95 @@
+#ifndef BUDGET_SPEC_HPP
+#define BUDGET_SPEC_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include <tdzdd/DdSpec.hpp>
+
+namespace hybriddd {
+
+// node / time budget of one DD construction. once it is exceeded every
+// remaining child goes to the 0-terminal, so the builder drains quickly.
+// the counters are atomic since MP builders spend it from several threads
+class DdBudget {
+private:
+	const std::atomic< size_t >* max_nodes; // may be lowered by other threads
+	double max_sec;                         // <= 0 for no limit
+	std::atomic< size_t > nodes;
+	std::atomic< bool > exceeded;
+	std::chrono::steady_clock::time_point start;
+
+public:
+	DdBudget(const std::atomic< size_t >* max_nodes_, double max_sec_ = 0)
+	: max_nodes(max_nodes_), max_sec(max_sec_), nodes(0), exceeded(false),
+	  start(std::chrono::steady_clock::now()) {}
+
+	// called once per expanded node
+	void spend() {
+		if (exceeded.load(std::memory_order_relaxed)) return;
+
+		size_t k = nodes.fetch_add(1, std::memory_order_relaxed) + 1;
+		if (k > max_nodes->load(std::memory_order_relaxed))
+			exceeded.store(true, std::memory_order_relaxed);
+
+		if (max_sec > 0 && (k & 1023) == 0) {
+			std::chrono::duration< double > el = std::chrono::steady_clock::now() - start;
+			if (el.count() > max_sec) exceeded.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	size_t getNodes() const { return nodes.load(std::memory_order_relaxed); }
+	bool isExceeded() const { return exceeded.load(std::memory_order_relaxed); }
+};
+
+// passes S through, cutting the construction off when the budget runs out
+template < typename S >
+class BudgetSpec : public tdzdd::DdSpecBase< BudgetSpec< S >, S::ARITY > {
+private:
+	S spec;
+	DdBudget* budget;
+
+public:
+	BudgetSpec(const S& s, DdBudget& b) : spec(s), budget(&b) {}
+
+	int datasize() const { return spec.datasize(); }
+
+	int get_root(void* p) { return spec.get_root(p); }
+
+	int get_child(void* p, int level, int b) {
+		if (b == 0) budget->spend();
+		if (budget->isExceeded()) return 0;
+		return spec.get_child(p, level, b);
+	}
+
+	void get_copy(void* to, const void* from) { spec.get_copy(to, from); }
+
+	int merge_states(void* p1, void* p2) { return spec.merge_states(p1, p2); }
+
+	void destruct(void* p) { spec.destruct(p); }
+
+	void destructLevel(int level) { spec.destructLevel(level); }
+
+	size_t hash_code(const void* p, int level) const { return spec.hash_code(p, level); }
+
+	bool equal_to(const void* p, const void* q, int level) const {
+		return spec.equal_to(p, q, level);
+	}
+
+	void print_state(std::ostream& os, const void* p, int level) const {
+		spec.print_state(os, p, level);
+	}
+
+	void print_level(std::ostream& os, int level) const { spec.print_level(os, level); }
+};
+
+template < typename S >
+BudgetSpec< S > budgeted(const S& spec, DdBudget& budget) {
+	return BudgetSpec< S >(spec, budget);
+}
+
+} // namespace hybriddd
+
+#endif // BUDGET_SPEC_HPP
@@ -4,12 +4,15 @@
 #include <tdzdd/DdSpec.hpp>
 #include "../util/Graph.hpp"
 #include "../util/IntSubset.hpp"
+#include "../util/CCLabel.hpp"
 
 namespace hybriddd {
 
-class CCS : public tdzdd::PodHybridDdSpec< CCS, int, int, 2 > {
+// T: component ids in the mate array (see MyTdZdd::withMateWidth)
+template < typename T = int >
+class CCS : public tdzdd::PodHybridDdSpec< CCS< T >, int, T, 2 > {
 private:
-	typedef int Mate;
+	typedef T Mate;
 	typedef int Counter;
 	
 	static const Mate IN = 0;
@@ -29,64 +32,19 @@ private:
 	mutable IntSubset terminals;
 	
 	Mate getCCid(Mate* mate) const {
-		Mate res = -1;
-		for (size_t i = 0; i < mate_size; ++i)
-			res = std::max(res, mate[i]);
-		return res + 1;
+		return CCLabel< Mate >::newId(mate, mate_size);
 	}
 	
 	void ccLink(Mate* mate, Mate& m1, Mate& m2) const {
-		Mate a = std::min(m1, m2);
-		Mate b = std::max(m1, m2);
-		m1 = m2 = a;
-		
-		for (size_t i = 0; i < mate_size; ++i) if (mate[i] == b) mate[i] = a;
-		
-		Vec< Mate > trans(mate_size + 5, NIL);
-		Mate cur = 0;
-		for (size_t i = 0; i < mate_size; ++i) {
-			Mate mi = mate[i];
-			if (mi >= IN) {
-				if (trans[mi] == NIL) {
-					mate[i] = trans[mi] = cur++;
-				} else {
-					mate[i] = trans[mi];
-				}
-			}
-		}
-		
-		/*
-		for (size_t i = 0; i < mate_size; ++i) {
-			if (mate[i] == b) mate[i] = a;
-			if (mate[i] > b) --mate[i];
-		}
-		
-		typedef std::pair< int, int > pii;
-		Vec< pii > vp(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) vp[i] = pii(0, i);
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) ++vp[mate[i]].first;
-		std::sort(vp.begin(), vp.end(), greater< pii >());
-		
-		Vec< int > next(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) next[vp[i].second] = i;
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) mate[i] = next[mate[i]];
-		*/
+		CCLabel< Mate >::link(mate, mate_size, m1, m2);
 	}
 	
 	bool linkCheck(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] == cc) return true;
-		return false;
+		return CCLabel< Mate >::contains(mate, mate_size, cc);
 	}
 	
 	bool otherCCs(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN && mate[i] != cc) return true;
-		return false;
+		return CCLabel< Mate >::hasOther(mate, mate_size, cc);
 	}
 	
 	int removeVertex(Counter& counter, Mate* mate, size_t i) const {
@@ -125,7 +83,7 @@ public:
 	steiner(!terminals_.empty()),
 	cc_constraint(cc_constraint_),
 	terminals(terminals_) {
-		setArraySize(mate_size);
+		this->setArraySize(mate_size);
 	}
 	
 	int getRoot(Counter& counter, Mate* mate) const {
@@ -4,12 +4,18 @@
 #include <tdzdd/DdSpec.hpp>
 #include "../util/HybridGraph.hpp"
 #include "../util/IntSubset.hpp"
+#include "../util/CCLabel.hpp"
 
 namespace hybriddd {
 
-class CCS_HV : public tdzdd::PodHybridDdSpec< CCS_HV, int, int, 2 > {
+// T: component ids in the mate array (see MyTdZdd::withMateWidth)
+template < typename T = int >
+class CCS_HV : public tdzdd::PodHybridDdSpec< CCS_HV< T >, int, T, 2 > {
 private:
-	typedef int Mate;
+	typedef tdzdd::PodHybridDdSpec< CCS_HV< T >, int, T, 2 > Base;
+	typedef typename Base::A_State Mate;
+	typedef typename Base::A_Array Mates;
+	typedef typename Base::A_Ref MateRef;
 	typedef int Counter;
 	
 	static const int STEINER_SHIFT = 16;
@@ -31,64 +37,20 @@ private:
 	mutable IntSubset cc_constraint;
 	mutable IntSubset terminals;
 	
-	Mate getCCid(Mate* mate) const {
-		Mate res = -1;
-		for (size_t i = 0; i < mate_size; ++i)
-			res = std::max(res, mate[i]);
-		return res + 1;
+	Mate getCCid(Mates mate) const {
+		return CCLabel< Mate >::newId(mate, mate_size);
 	}
 	
-	void ccLink(Mate* mate, Mate& m1, Mate& m2) const {
-		Mate a = std::min(m1, m2);
-		Mate b = std::max(m1, m2);
-		m1 = m2 = a;
-		
-		for (size_t i = 0; i < mate_size; ++i) if (mate[i] == b) mate[i] = a;
-		
-		Vec< Mate > trans(mate_size + 5, NIL);
-		Mate cur = 0;
-		for (size_t i = 0; i < mate_size; ++i) {
-			Mate mi = mate[i];
-			if (mi >= IN) {
-				if (trans[mi] == NIL) {
-					mate[i] = trans[mi] = cur++;
-				} else {
-					mate[i] = trans[mi];
-				}
-			}
-		}
-		/*
-		for (size_t i = 0; i < mate_size; ++i) {
-			if (mate[i] == b) mate[i] = a;
-			if (mate[i] > b) --mate[i];
-		}
-		
-		typedef std::pair< Mate, Mate > pii;
-		Vec< pii > vp(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) vp[i] = pii(0, i);
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) ++vp[mate[i]].first;
-		std::sort(vp.begin(), vp.end(), greater< pii >());
-		
-		Vec< Mate > next(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) next[vp[i].second] = i;
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) mate[i] = next[mate[i]];
-		*/
+	void ccLink(Mates mate, MateRef& m1, MateRef& m2) const {
+		CCLabel< Mate >::link(mate, mate_size, m1, m2);
 	}
 	
-	bool linkCheck(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] == cc) return true;
-		return false;
+	bool linkCheck(Mates mate, Mate cc) const {
+		return CCLabel< Mate >::contains(mate, mate_size, cc);
 	}
 	
-	bool otherCCs(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN && mate[i] != cc) return true;
-		return false;
+	bool otherCCs(Mates mate, Mate cc) const {
+		return CCLabel< Mate >::hasOther(mate, mate_size, cc);
 	}
 	
 public:
@@ -102,23 +64,23 @@ public:
 	steiner(!terminals_.empty()),
 	cc_constraint(cc_constraint_),
 	terminals(terminals_) {
-		setArraySize(mate_size);
+		this->setArraySize(mate_size);
 	}
 	
-	int getRoot(Counter& counter, Mate* mate) const {
+	int getRoot(Counter& counter, Mates mate) const {
 		counter = steiner ? (terminals.size() << STEINER_SHIFT) : 0;
 		for (size_t i = 0; i < mate_size; ++i) mate[i] = NIL;
 		return n;
 	}
 	
-	int getChild(Counter& counter, Mate* mate, int level, bool take) const {
+	int getChild(Counter& counter, Mates mate, int level, bool take) const {
 		assert(1 <= level && level <= n);
 		
 		int i = n - level;
 		const HybridGraph::Item& item = graph.getItemAf(i);
 		
 		if (item.isvertex) {
-			Mate& m = mate[item.i];
+			MateRef m = mate[item.i];
 			
 			if (take && m == NIL) return 0;
 			if (!take && m >= IN) return 0;
@@ -160,8 +122,8 @@ public:
 			return n - i;
 		}
 		
-		Mate& m1 = mate[item.i1];
-		Mate& m2 = mate[item.i2];
+		MateRef m1 = mate[item.i1];
+		MateRef m2 = mate[item.i2];
 		
 		if (take) {
 			if (forest && m1 >= IN && m2 >= IN && m1 == m2) return 0;
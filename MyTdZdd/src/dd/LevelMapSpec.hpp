@@ -0,0 +1,77 @@
+#ifndef LEVEL_MAP_SPEC_HPP
+#define LEVEL_MAP_SPEC_HPP
+
+#include <cassert>
+#include <iostream>
+
+#include <tdzdd/DdSpec.hpp>
+
+#include "../util/commons.hpp"
+
+namespace hybriddd {
+
+// S with its levels renumbered by an increasing map (map[0] = 0).
+// levels that are skipped become 0 in the ZDD sense
+template < typename S >
+class LevelMapSpec : public tdzdd::DdSpecBase< LevelMapSpec< S >, S::ARITY > {
+private:
+	S spec;
+	Vec< int > map; // level of S -> level
+	Vec< int > inv; // level -> level of S (-1 if not in the image)
+
+	int lift(int level) const { return level > 0 ? map[level] : level; }
+
+public:
+	LevelMapSpec(const S& s, const Vec< int >& map_) : spec(s), map(map_) {
+		assert(!map.empty() && map[0] == 0);
+		inv.assign(map.back() + 1, -1);
+		for (size_t l = 0; l < map.size(); ++l) {
+			assert(l == 0 || map[l] > map[l - 1]);
+			inv[map[l]] = l;
+		}
+	}
+
+	int datasize() const { return spec.datasize(); }
+
+	int get_root(void* p) { return lift(spec.get_root(p)); }
+
+	int get_child(void* p, int level, int b) {
+		assert(inv[level] > 0);
+		return lift(spec.get_child(p, inv[level], b));
+	}
+
+	void get_copy(void* to, const void* from) { spec.get_copy(to, from); }
+
+	int merge_states(void* p1, void* p2) { return spec.merge_states(p1, p2); }
+
+	void destruct(void* p) { spec.destruct(p); }
+
+	void destructLevel(int level) {
+		if (level < (int)inv.size() && inv[level] > 0) spec.destructLevel(inv[level]);
+	}
+
+	size_t hash_code(const void* p, int level) const {
+		return spec.hash_code(p, inv[level]);
+	}
+
+	bool equal_to(const void* p, const void* q, int level) const {
+		return spec.equal_to(p, q, inv[level]);
+	}
+
+	void print_state(std::ostream& os, const void* p, int level) const {
+		spec.print_state(os, p, inv[level]);
+	}
+
+	void print_level(std::ostream& os, int level) const {
+		spec.print_level(os, inv[level]);
+	}
+};
+
+template < typename S >
+LevelMapSpec< S > levelMapped(const S& spec, const Vec< int >& map) {
+	return LevelMapSpec< S >(spec, map);
+}
+
+} // namespace hybriddd
+
+#endif // LEVEL_MAP_SPEC_HPP
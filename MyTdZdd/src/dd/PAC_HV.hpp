@@ -10,17 +10,19 @@ namespace simpath_hv  {
 
 const static int16_t INTER = -123;
 
+// end points of a path, T holds vertex ids
+template < typename T >
 struct Path {
-	int16_t s, t;
+	T s, t;
 	
 	Path() { s = t = INTER; }
 	
-	void init(int16_t s_) { s = s_; t = s_; }
+	void init(T s_) { s = s_; t = s_; }
 	void setInterPath() { t = INTER; }
-	void setTerminal(int16_t u) { t = u; }
+	void setTerminal(T u) { t = u; }
 	
 	bool isOuterPath() { return s == t; }
-	bool terminalIs(int16_t u) { return t == u; }
+	bool terminalIs(T u) { return t == u; }
 	bool isInterPath() { return t == INTER; }
 	bool isTerminal() { return !isInterPath() && t != s; }
 	
@@ -35,9 +37,11 @@ struct Path {
 
 };
 
-class PAC_HV : public tdzdd::PodHybridDdSpec< PAC_HV, bool, simpath_hv::Path, 2 > {
+// T: vertex ids (see MyTdZdd::withMateWidth)
+template < typename T = int16_t >
+class PAC_HV : public tdzdd::PodHybridDdSpec< PAC_HV< T >, bool, simpath_hv::Path< T >, 2 > {
 private:
-	typedef simpath_hv::Path Mate;
+	typedef simpath_hv::Path< T > Mate;
 	
 	const HybridGraph& graph;
 	const int n;
@@ -66,7 +70,7 @@ public:
 	: graph(graph_), n(graph_.getNumOfI()),
 	mate_size(graph_.getMaxFSize()),
 	s(s_), t(t_), cycle(s_ == -1 || t_ == -1) {
-		setArraySize(mate_size);
+		this->setArraySize(mate_size);
 	}
 	
 	int getRoot(bool& complete, Mate* mate) const {
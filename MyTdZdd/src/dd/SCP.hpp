@@ -4,6 +4,7 @@
 #include <tdzdd/DdSpec.hpp>
 #include "../util/HybridGraph.hpp"
 #include "../util/IntSubset.hpp"
+#include "../util/CCLabel.hpp"
 
 namespace hybriddd {
 
@@ -23,62 +24,36 @@ private:
 	const int n;
 	const size_t mate_size;
 	
-	void reject(Mate* mate, const USet< int >& adj) const {
+	void reject(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			if (mate[t] == DNC) mate[t] = OUT;
 		}
 	}
 	
 	Mate getCCid(Mate* mate) const {
-		Mate res = -1;
-		for (size_t i = 0; i < mate_size; ++i)
-			res = std::max(res, mate[i]);
-		return res + 1;
+		return CCLabel< Mate >::newId(mate, mate_size);
 	}
 	
 	void ccLink(Mate* mate, Mate& m1, Mate& m2) const {
-		Mate a = std::min(m1, m2);
-		Mate b = std::max(m1, m2);
-		m1 = m2 = a;
-		
-		for (size_t i = 0; i < mate_size; ++i) {
-			if (mate[i] == b) mate[i] = a;
-			if (mate[i] > b) --mate[i];
-		}
-		
-		typedef std::pair< int, int > pii;
-		Vec< pii > vp(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) vp[i] = pii(0, i);
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) ++vp[mate[i]].first;
-		std::sort(vp.begin(), vp.end(), greater< pii >());
-		
-		Vec< int > next(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) next[vp[i].second] = i;
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) mate[i] = next[mate[i]];
+		CCLabel< Mate >::link(mate, mate_size, m1, m2);
 	}
 	
 	bool linkCheck(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i) if (mate[i] == cc) return true;
-		return false;
+		return CCLabel< Mate >::contains(mate, mate_size, cc);
 	}
 	
 	bool otherCCs(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i) if (mate[i] >= IN && mate[i] != cc) return true;
-		return false;
+		return CCLabel< Mate >::hasOther(mate, mate_size, cc);
 	}
 	
-	void setIsolate(Mate* mate, const USet< int >& adj) const {
+	void setIsolate(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			mate[t] = OUT;
 		}
 	}
@@ -114,9 +89,8 @@ public:
 			if (!take && m >= IN) return 0;
 			
 			if (take && m == DNC) {
-				const HybridGraph::AddInfoHV addinfo = graph.getAddInfoAf(i);
 				m = getCCid(mate);
-				setIsolate(mate, addinfo.adj);
+				setIsolate(mate, graph.getAdjMatesAf(i));
 			}
 			
 			Mate cc = m;
@@ -137,16 +111,14 @@ public:
 		if (take) {
 			if (m1 == OUT || m2 == OUT) return 0;
 			
-			const HybridGraph::AddInfoHV addinfo = graph.getAddInfoAf(i);
-			
 			if (m1 == DNC) {
 				m1 = getCCid(mate);
-				reject(mate, addinfo.adj1);
+				reject(mate, graph.getAdjMates1Af(i));
 			}
 			
 			if (m2 == DNC) {
 				m2 = getCCid(mate);
-				reject(mate, addinfo.adj2);
+				reject(mate, graph.getAdjMates2Af(i));
 			}
 			
 			if (m1 != m2) ccLink(mate, m1, m2);
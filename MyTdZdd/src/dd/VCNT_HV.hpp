@@ -31,7 +31,7 @@ public:
 		}
 		
 		int i = n - level;
-		const HybridGraph::Item item = graph.getItemAf(i);
+		const HybridGraph::Item& item = graph.getItemAf(i);
 		
 		if (item.isvertex) {
 			if (take) {
@@ -4,12 +4,15 @@
 #include <tdzdd/DdSpec.hpp>
 #include "../util/HybridGraph.hpp"
 #include "../util/IntSubset.hpp"
+#include "../util/CCLabel.hpp"
 
 namespace hybriddd {
 
-class VCUT : public tdzdd::PodHybridDdSpec< VCUT, int16_t, int16_t, 2 > {
+// T: component ids in the mate array (see MyTdZdd::withMateWidth)
+template < typename T = int16_t >
+class VCUT : public tdzdd::PodHybridDdSpec< VCUT< T >, int16_t, T, 2 > {
 private:
-	typedef int16_t Mate;
+	typedef T Mate;
 	typedef int16_t Counter;
 	
 	static const Mate DNC = -1; // don't care
@@ -21,20 +24,20 @@ private:
 	const size_t mate_size;
 	mutable IntSubset constraint;
 	
-	void reject(Mate* mate, const USet< int >& adj) const {
+	void reject(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			if (mate[t] == DNC) mate[t] = OUT;
 		}
 	}	
 	
-	bool loopCheck(Mate* mate, const USet< int >& adj) const {
+	bool loopCheck(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			if (mate[t] >= IN) return false;
 		}
 		
@@ -42,54 +45,26 @@ private:
 	}
 	
 	Mate getCCid(Mate* mate) const {
-		Mate res = -1;
-		for (size_t i = 0; i < mate_size; ++i)
-			res = std::max(res, mate[i]);
-		return res + 1;
+		return CCLabel< Mate >::newId(mate, mate_size);
 	}
 	
 	void ccLink(Mate* mate, Mate& m1, Mate& m2) const {
-		Mate a = std::min(m1, m2);
-		Mate b = std::max(m1, m2);
-		m1 = m2 = a;
-		
-		for (size_t i = 0; i < mate_size; ++i) {
-			if (mate[i] == b) mate[i] = a;
-			if (mate[i] > b) --mate[i];
-		}
-		
-		typedef std::pair< int, int > pii;
-		Vec< pii > vp(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) vp[i] = pii(0, i);
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) ++vp[mate[i]].first;
-		std::sort(vp.begin(), vp.end(), greater< pii >());
-		
-		Vec< int > next(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) next[vp[i].second] = i;
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) mate[i] = next[mate[i]];
+		CCLabel< Mate >::link(mate, mate_size, m1, m2);
 	}
 	
 	bool linkCheck(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] == cc) return true;
-		return false;
+		return CCLabel< Mate >::contains(mate, mate_size, cc);
 	}
 	
 	bool otherCCs(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN && mate[i] != cc) return true;
-		return false;
+		return CCLabel< Mate >::hasOther(mate, mate_size, cc);
 	}
 	
-	void setIsolate(Mate* mate, const USet< int >& adj) const {
+	void setIsolate(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			mate[t] = OUT;
 		}
 	}
@@ -120,7 +95,7 @@ public:
 	: graph(graph_), n(graph_.getNumOfE()),
 	mate_size(graph_.getMaxFSize()),
 	constraint(constraint_) {
-		setArraySize(mate_size);
+		this->setArraySize(mate_size);
 		
 		// 必ず2分割以上になるような制約
 		if (constraint.empty()) {
@@ -153,16 +128,14 @@ public:
 		if (!take) {
 			if (m1 == OUT || m2 == OUT) return 0;
 			
-			Graph::AddInfo addinfo = graph.getAddInfo(i);
-			
 			if (m1 == DNC) {
 				m1 = getCCid(mate);
-				reject(mate, addinfo.adj1);
+				reject(mate, graph.getAdjMates1(i));
 			}
 			
 			if (m2 == DNC) {
 				m2 = getCCid(mate);
-				reject(mate, addinfo.adj2);
+				reject(mate, graph.getAdjMates2(i));
 			}
 			
 			if (m1 != m2) ccLink(mate, m1, m2);
@@ -30,7 +30,7 @@ public:
 		
 		int i = n - level;
 		
-		const HybridGraph::Item item = graph.getItemAf(i);
+		const HybridGraph::Item& item = graph.getItemAf(i);
 		
 		if (item.isvertex) {
 			if (!take && select.contain(item.v)) return 0;
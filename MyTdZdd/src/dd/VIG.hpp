@@ -4,6 +4,7 @@
 #include <tdzdd/DdSpec.hpp>
 #include "../util/HybridGraph.hpp"
 #include "../util/IntSubset.hpp"
+#include "../util/CCLabel.hpp"
 
 namespace hybriddd {
 
@@ -15,7 +16,6 @@ private:
 	static const Mate DNC = -1; // don't care
 	static const Mate IN = 0; // in
 	static const Mate OUT = -2; // out
-	static const Mate NIL = -1;
 	
 	const Graph& graph;
 	const int n;
@@ -24,20 +24,20 @@ private:
 	const bool forest;
 	mutable IntSubset cc_constraint;
 	
-	void reject(Mate* mate, const USet< int >& adj) const {
+	void reject(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			if (mate[t] == DNC) mate[t] = OUT;
 		}
 	}
 	
-	bool loopCheck(Mate* mate, const USet< int >& adj) const {
+	bool loopCheck(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			if (mate[t] >= IN) return false;
 		}
 		
@@ -45,68 +45,26 @@ private:
 	}
 	
 	Mate getCCid(Mate* mate) const {
-		Mate res = -1;
-		for (size_t i = 0; i < mate_size; ++i)
-			res = std::max(res, mate[i]);
-		return res + 1;
+		return CCLabel< Mate >::newId(mate, mate_size);
 	}
 	
 	void ccLink(Mate* mate, Mate& m1, Mate& m2) const {
-		Mate a = std::min(m1, m2);
-		Mate b = std::max(m1, m2);
-		m1 = m2 = a;
-		
-		Vec< Mate > trans(mate_size + 5, NIL);
-		Mate cur = 0;
-		for (size_t i = 0; i < mate_size; ++i) {
-			Mate mi = mate[i];
-			if (mi >= IN) {
-				if (trans[mi] == NIL) {
-					mate[i] = trans[mi] = cur++;
-				} else {
-					mate[i] = trans[mi];
-				}
-			}
-		}
-		/*
-		for (size_t i = 0; i < mate_size; ++i) {
-			if (mate[i] == b) mate[i] = a;
-			if (mate[i] > b) --mate[i];
-		}
-		
-		typedef std::pair< int, int > pii;
-		Vec< pii > vp(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) vp[i] = pii(0, i);
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) ++vp[mate[i]].first;
-		std::sort(vp.begin(), vp.end(), greater< pii >());
-		
-		Vec< size_t > next(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) next[vp[i].second] = i;
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) mate[i] = next[mate[i]];
-		*/
+		CCLabel< Mate >::link(mate, mate_size, m1, m2);
 	}
 	
 	bool linkCheck(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] == cc) return true;
-		return false;
+		return CCLabel< Mate >::contains(mate, mate_size, cc);
 	}
 	
 	bool otherCCs(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN && mate[i] != cc) return true;
-		return false;
+		return CCLabel< Mate >::hasOther(mate, mate_size, cc);
 	}
 	
-	void setIsolate(Mate* mate, const USet< int >& adj) const {
+	void setIsolate(Mate* mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			mate[t] = OUT;
 		}
 	}
@@ -167,18 +125,16 @@ public:
 			
 			if (forest && m1 >= IN && m2 >= IN && m1 == m2) return 0;
 			
-			const Graph::AddInfo addinfo = graph.getAddInfo(i);
-			
 			if (m1 == DNC) {
-				if (forest && !loopCheck(mate, addinfo.adj1)) return 0;
+				if (forest && !loopCheck(mate, graph.getAdjMates1(i))) return 0;
 				m1 = (connected || forest) ? getCCid(mate) : IN;
-				reject(mate, addinfo.adj1);
+				reject(mate, graph.getAdjMates1(i));
 			}
 			
 			if (m2 == DNC) {
-				if (forest && !loopCheck(mate, addinfo.adj2)) return 0;
+				if (forest && !loopCheck(mate, graph.getAdjMates2(i))) return 0;
 				m2 = (connected || forest) ? getCCid(mate) : IN;
-				reject(mate, addinfo.adj2);
+				reject(mate, graph.getAdjMates2(i));
 			}
 			
 			if (m1 != m2) ccLink(mate, m1, m2);
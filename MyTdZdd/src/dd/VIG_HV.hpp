@@ -4,18 +4,24 @@
 #include <tdzdd/DdSpec.hpp>
 #include "../util/HybridGraph.hpp"
 #include "../util/IntSubset.hpp"
+#include "../util/CCLabel.hpp"
 
 namespace hybriddd {
 
-class VIG_HV : public tdzdd::PodHybridDdSpec< VIG_HV, int16_t, int16_t, 2 > {
+// T: component ids in the mate array, an integer type or tdzdd::PackedBits
+// (see MyTdZdd::withPackedMates)
+template < typename T = int16_t >
+class VIG_HV : public tdzdd::PodHybridDdSpec< VIG_HV< T >, int16_t, T, 2 > {
 private:
-	typedef int16_t Mate;
+	typedef tdzdd::PodHybridDdSpec< VIG_HV< T >, int16_t, T, 2 > Base;
+	typedef typename Base::A_State Mate;
+	typedef typename Base::A_Array Mates;
+	typedef typename Base::A_Ref MateRef;
 	typedef int16_t Counter;
 	
 	static const Mate DNC = -1; // don't care
 	static const Mate IN = 0; // in
 	static const Mate OUT = -2; // out
-	static const Mate NIL = -1;
 	
 	const HybridGraph& graph;
 	const int n;
@@ -25,87 +31,47 @@ private:
 	const bool noisolate;
 	mutable IntSubset cc_constraint;
 	
-	void reject(Mate* mate, const USet< int >& adj) const {
+	void reject(Mates mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			if (mate[t] == DNC) mate[t] = OUT;
 		}
 	}
 	
-	bool loopCheck(Mate* mate, const USet< int >& adj) const {
+	bool loopCheck(Mates mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			if (mate[t] >= IN) return false;
 		}
 		
 		return true;
 	}
 	
-	Mate getCCid(Mate* mate) const {
-		Mate res = -1;
-		for (size_t i = 0; i < mate_size; ++i)
-			res = std::max(res, mate[i]);
-		return res + 1;
+	Mate getCCid(Mates mate) const {
+		return CCLabel< Mate >::newId(mate, mate_size);
 	}
 	
-	void ccLink(Mate* mate, Mate& m1, Mate& m2) const {
-		Mate a = std::min(m1, m2);
-		Mate b = std::max(m1, m2);
-		m1 = m2 = a;
-		
-		Vec< Mate > trans(mate_size + 5, NIL);
-		Mate cur = 0;
-		for (size_t i = 0; i < mate_size; ++i) {
-			Mate mi = mate[i];
-			if (mi >= IN) {
-				if (trans[mi] == NIL) {
-					mate[i] = trans[mi] = cur++;
-				} else {
-					mate[i] = trans[mi];
-				}
-			}
-		}
-		/*
-		for (size_t i = 0; i < mate_size; ++i) {
-			if (mate[i] == b) mate[i] = a;
-			if (mate[i] > b) --mate[i];
-		}
-		
-		typedef std::pair< int, int > pii;
-		Vec< pii > vp(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) vp[i] = pii(0, i);
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) ++vp[mate[i]].first;
-		std::sort(vp.begin(), vp.end(), greater< pii >());
-		
-		Vec< int > next(mate_size);
-		for (size_t i = 0; i < mate_size; ++i) next[vp[i].second] = i;
-		
-		for (size_t i = 0; i < mate_size; ++i)
-			if (mate[i] >= IN) mate[i] = next[mate[i]];
-		*/
+	void ccLink(Mates mate, MateRef& m1, MateRef& m2) const {
+		CCLabel< Mate >::link(mate, mate_size, m1, m2);
 	}
 	
-	bool linkCheck(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i) if (mate[i] == cc) return true;
-		return false;
+	bool linkCheck(Mates mate, Mate cc) const {
+		return CCLabel< Mate >::contains(mate, mate_size, cc);
 	}
 	
-	bool otherCCs(Mate* mate, Mate cc) const {
-		for (size_t i = 0; i < mate_size; ++i) if (mate[i] >= IN && mate[i] != cc) return true;
-		return false;
+	bool otherCCs(Mates mate, Mate cc) const {
+		return CCLabel< Mate >::hasOther(mate, mate_size, cc);
 	}
 	
-	void setIsolate(Mate* mate, const USet< int >& adj) const {
+	void setIsolate(Mates mate, const MateRange& adj) const {
 		auto it = adj.begin(), eit = adj.end();
 		
 		for (; it != eit; ++it) {
-			int t = graph.getMateI((*it));
+			size_t t = *it;
 			mate[t] = OUT;
 		}
 	}
@@ -118,32 +84,31 @@ public:
 	connected(mode == "connected" || mode == "tree"),
 	forest(mode == "forest" || mode == "tree"),
 	noisolate(nois), cc_constraint(cc_constraint_) {
-		setArraySize(mate_size);
+		this->setArraySize(mate_size);
 	}
 	
-	int getRoot(Counter& counter, Mate* mate) const {
+	int getRoot(Counter& counter, Mates mate) const {
 		counter = 0;
 		for (size_t i = 0; i < mate_size; ++i) mate[i] = DNC;
 		return n;
 	}
 	
-	int getChild(Counter& counter, Mate* mate, int level, bool take) const {
+	int getChild(Counter& counter, Mates mate, int level, bool take) const {
 		assert(1 <= level && level <= n);
 		
 		int i = n - level;
 		const HybridGraph::Item& item = graph.getItemAf(i);
 		
 		if (item.isvertex) {
-			Mate& m = mate[item.i];
+			MateRef m = mate[item.i];
 			
 			if (take && m == OUT) return 0;
 			if (!take && m >= IN) return 0;
 			
 			if (take && m == DNC) {
 				if (noisolate) return 0;
-				const HybridGraph::AddInfoHV addinfo = graph.getAddInfoAf(i);
 				m = (connected || forest) ? getCCid(mate) : IN;
-				setIsolate(mate, addinfo.adj);
+				setIsolate(mate, graph.getAdjMatesAf(i));
 			}
 			
 			Mate cc = m;
@@ -174,26 +139,24 @@ public:
 			return n - i;
 		}
 		
-		Mate& m1 = mate[item.i1];
-		Mate& m2 = mate[item.i2];
+		MateRef m1 = mate[item.i1];
+		MateRef m2 = mate[item.i2];
 		
 		if (take) {
 			if (m1 == OUT || m2 == OUT) return 0;
 			
 			if (forest && m1 >= IN && m2 >= IN && m1 == m2) return 0;
 			
-			const HybridGraph::AddInfoHV addinfo = graph.getAddInfoAf(i);
-			
 			if (m1 == DNC) {
-				if (forest && !loopCheck(mate, addinfo.adj1)) return 0;
+				if (forest && !loopCheck(mate, graph.getAdjMates1Af(i))) return 0;
 				m1 = (connected || forest) ? getCCid(mate) : IN;
-				reject(mate, addinfo.adj1);
+				reject(mate, graph.getAdjMates1Af(i));
 			}
 			
 			if (m2 == DNC) {
-				if (forest && !loopCheck(mate, addinfo.adj2)) return 0;
+				if (forest && !loopCheck(mate, graph.getAdjMates2Af(i))) return 0;
 				m2 = (connected || forest) ? getCCid(mate) : IN;
-				reject(mate, addinfo.adj2);
+				reject(mate, graph.getAdjMates2Af(i));
 			}
 			
 			if (m1 != m2) ccLink(mate, m1, m2);
@@ -17,8 +17,15 @@ using namespace tdzdd;
 #include "util/XorShift.hpp"
 #include "util/commons.hpp"
 #include "util/MyValues.hpp"
+#include "util/MateTable.hpp"
+#include "util/CCLabel.hpp"
+#include "util/EdgeListFile.hpp"
+#include "util/GraphCache.hpp"
+#include "util/BlockGraph.hpp"
 
 // include dd
+#include "dd/BudgetSpec.hpp"
+#include "dd/LevelMapSpec.hpp"
 #include "dd/ImportZDD.hpp"
 #include "dd/ECNT_HV.hpp"
 #include "dd/VCNT_HV.hpp"
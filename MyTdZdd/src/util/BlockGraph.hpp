@@ -0,0 +1,147 @@
+#ifndef BLOCK_GRAPH_HPP
+#define BLOCK_GRAPH_HPP
+
+#include <cassert>
+#include <queue>
+#include <string>
+
+#include "commons.hpp"
+#include "HybridGraph.hpp"
+
+namespace hybriddd {
+
+// union of selected blocks of a graph, compiled on its own.
+// the edges of the union keep their order in the graph, which is not
+// changed, so the edge levels of a DD over sub lift to the graph by
+// renumbering. the items with vertex variables lift the same way only if a
+// vertex of the union leaves the frontier of the graph before the next item
+// of the union; liftsHV() tells if they do
+class BlockGraph {
+public:
+	typedef Graph::pii pii;
+
+private:
+	HybridGraph sub;
+	Vec< int > orig;  // vertex of sub -> vertex of the whole graph
+	Vec< int > local; // vertex of the whole graph -> vertex of sub (-1 if none)
+	Vec< int > lev_map;    // level of sub (edges) -> level of the whole graph
+	Vec< int > lev_map_hv; // level of sub (items) -> level of the whole graph
+	bool lifts_hv;
+
+public:
+	BlockGraph(const HybridGraph& graph, const Vec< Vec< pii > >& blocks)
+	: local(graph.getNumOfV(), -1), lifts_hv(true) {
+		assert(!blocks.empty());
+		
+		MyUMap< pii, int, Graph::PiiHash > cnt;
+		for (const Vec< pii >& b : blocks)
+			for (const pii& e : b) ++cnt[e];
+		
+		// the edges of the blocks in the order of graph
+		Vec< size_t > eids; // edge of sub -> edge of the whole graph
+		Vec< pii > sub_edges;
+		for (size_t i = 0; i < graph.getNumOfE(); ++i) {
+			const Graph::Edge& e = graph.getEdge(i);
+			auto it = cnt.find(pii(e.v1, e.v2));
+			if (it == cnt.end() || it->second == 0) it = cnt.find(pii(e.v2, e.v1));
+			if (it == cnt.end() || it->second == 0) continue;
+			--it->second;
+			
+			for (int v : {e.v1, e.v2}) {
+				if (local[v] >= 0) continue;
+				local[v] = orig.size();
+				orig.push_back(v);
+			}
+			eids.push_back(i);
+			sub_edges.push_back(pii(local[e.v1], local[e.v2]));
+		}
+		
+		sub = HybridGraph(orig.size());
+		sub.addEdges(sub_edges);
+		sub.setOrder("as-is");
+		sub.setItems();
+		
+		size_t m = sub.getNumOfE(), E = graph.getNumOfE();
+		lev_map.assign(m + 1, 0);
+		for (size_t k = 0; k < m; ++k) lev_map[m - k] = E - eids[k];
+		
+		size_t n = sub.getNumOfI();
+		lev_map_hv.assign(n + 1, 0);
+		for (size_t k = 0; k < n; ++k) {
+			const HybridGraph::Item& item = sub.getItemAf(k);
+			size_t lev;
+			if (item.isvertex) {
+				lev = graph.getLevelAf(HybridGraph::Item(orig[item.v]));
+			} else {
+				size_t i = eids[item.eid];
+				lev = graph.getLevelAf(HybridGraph::Item(graph.getEdge(i), i));
+			}
+			lev_map_hv[n - k] = lev;
+			if (k > 0 && size_t(lev_map_hv[n - k + 1]) <= lev) lifts_hv = false;
+		}
+	}
+
+	const HybridGraph& getSub() const { return sub; }
+
+	int getLocal(int v) const { return local[v]; }
+
+	// level of an edge of sub in the whole graph
+	const Vec< int >& getLevelMap() const { return lev_map; }
+
+	// level of an item of sub in the whole graph, if liftsHV()
+	const Vec< int >& getLevelMapHV() const { return lev_map_hv; }
+
+	bool liftsHV() const { return lifts_hv; }
+
+	// blocks that hold a cycle: at least two edges, or a self-loop
+	static Vec< Vec< pii > > cyclicBlocks(const Vec< Vec< pii > >& blocks) {
+		Vec< Vec< pii > > res;
+		for (const Vec< pii >& b : blocks) {
+			if (b.size() >= 2 || b[0].first == b[0].second) res.push_back(b);
+		}
+		return res;
+	}
+
+	// blocks on the path from s to t in the block-cut tree (empty if s and t
+	// are not connected)
+	static Vec< Vec< pii > > pathBlocks(const Vec< Vec< pii > >& blocks,
+										size_t num_of_V, int s, int t) {
+		// bipartite graph of vertices [0, V) and blocks [V, V + B)
+		size_t V = num_of_V;
+		Vec< Vec< int > > adj(V + blocks.size());
+		for (size_t b = 0; b < blocks.size(); ++b) {
+			for (const pii& e : blocks[b]) {
+				for (int v : {e.first, e.second}) {
+					if (!adj[V + b].empty() && adj[V + b].back() == v) continue;
+					adj[V + b].push_back(v);
+					adj[v].push_back(V + b);
+				}
+			}
+		}
+
+		Vec< int > prev(adj.size(), -1);
+		std::queue< int > que;
+		que.push(s);
+		prev[s] = s;
+		while (!que.empty() && prev[t] < 0) {
+			int x = que.front(); que.pop();
+			for (int y : adj[x]) {
+				if (prev[y] >= 0) continue;
+				prev[y] = x;
+				que.push(y);
+			}
+		}
+
+		Vec< Vec< pii > > res;
+		if (prev[t] < 0) return res;
+		for (int x = t; x != s; x = prev[x]) {
+			if (x >= (int)V) res.push_back(blocks[x - V]);
+		}
+		std::reverse(res.begin(), res.end());
+		return res;
+	}
+};
+
+} // namespace hybriddd
+
+#endif // BLOCK_GRAPH_HPP
@@ -0,0 +1,78 @@
+#ifndef CC_LABEL_HPP
+#define CC_LABEL_HPP
+
+#include <cassert>
+#include <algorithm>
+
+#include "commons.hpp"
+
+namespace hybriddd {
+
+// connected component ids on a mate array shared by the frontier specs.
+// mate[i] >= 0 is a component id, negative values are spec-defined flags.
+// the array A is a Mate* or a packed array (tdzdd::PackedArray) of Mate
+// values, whose elements are accessed through a reference proxy R
+template < typename Mate >
+class CCLabel {
+private:
+	static const size_t SMALL_F = 64;
+
+	// merges b into a and renumbers ids in order of first appearance
+	template < typename A >
+	static void relabel(A mate, size_t F, Mate a, Mate b, Mate* trans) {
+		std::fill(trans, trans + F + 2, Mate(-1));
+
+		Mate cur = 0;
+		for (size_t i = 0; i < F; ++i) {
+			Mate mi = mate[i];
+			if (mi < 0) continue;
+			if (mi == b) mi = a;
+			assert(size_t(mi) < F + 2);
+			if (trans[mi] < 0) trans[mi] = cur++;
+			mate[i] = trans[mi];
+		}
+	}
+
+public:
+	// id for a component that is new to the frontier
+	template < typename A >
+	static Mate newId(A mate, size_t F) {
+		Mate res = -1;
+		for (size_t i = 0; i < F; ++i) res = std::max< Mate >(res, mate[i]);
+		return res + 1;
+	}
+
+	template < typename A >
+	static bool contains(A mate, size_t F, Mate cc) {
+		for (size_t i = 0; i < F; ++i) if (mate[i] == cc) return true;
+		return false;
+	}
+
+	template < typename A >
+	static bool hasOther(A mate, size_t F, Mate cc) {
+		for (size_t i = 0; i < F; ++i) if (mate[i] >= 0 && mate[i] != cc) return true;
+		return false;
+	}
+
+	// joins the components of m1 and m2 in place without touching the heap
+	// (ids never exceed F + 1, so the translation table fits in F + 2 slots)
+	template < typename A, typename R >
+	static void link(A mate, size_t F, R& m1, R& m2) {
+		Mate a = std::min< Mate >(m1, m2);
+		Mate b = std::max< Mate >(m1, m2);
+		m1 = m2 = a;
+
+		if (F <= SMALL_F) {
+			Mate trans[SMALL_F + 2];
+			relabel(mate, F, a, b, trans);
+		} else {
+			static thread_local Vec< Mate > trans;
+			if (trans.size() < F + 2) trans.resize(F + 2);
+			relabel(mate, F, a, b, trans.data());
+		}
+	}
+};
+
+} // namespace hybriddd
+
+#endif // CC_LABEL_HPP
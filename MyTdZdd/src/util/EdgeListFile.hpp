@@ -0,0 +1,114 @@
+#ifndef EDGE_LIST_FILE_HPP
+#define EDGE_LIST_FILE_HPP
+
+#include <charconv>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "commons.hpp"
+
+namespace hybriddd {
+
+// graph file reader ("|V| |E|" followed by |E| vertex pairs)
+// the file is mapped into memory and scanned once
+class EdgeListFile {
+public:
+	typedef std::pair< int, int > pii;
+
+private:
+	int num_of_V;
+	int num_of_E;
+	Vec< pii > edges;
+
+	static const char* skipSpace(const char* p, const char* end) {
+		while (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+		return p;
+	}
+
+	static bool nextInt(const char*& p, const char* end, int& x) {
+		p = skipSpace(p, end);
+		std::from_chars_result r = std::from_chars(p, end, x);
+		if (r.ec != std::errc()) return false;
+		p = r.ptr;
+		return true;
+	}
+
+	// maps the whole file read-only, exits on failure (len = 0 for an empty file)
+	static const char* map(std::string file_name, size_t& len) {
+		int fd = open(file_name.c_str(), O_RDONLY);
+		if (fd < 0) fopen_err(file_name);
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) fopen_err(file_name);
+
+		len = st.st_size;
+		if (len == 0) {
+			close(fd);
+			return NULL;
+		}
+
+		void* addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (addr == MAP_FAILED) fopen_err(file_name);
+
+		madvise(addr, len, MADV_SEQUENTIAL);
+		return static_cast< const char* >(addr);
+	}
+
+	void parse(const char* p, const char* end, std::string file_name) {
+		if (!nextInt(p, end, num_of_V) || !nextInt(p, end, num_of_E) ||
+			num_of_V < 0 || num_of_E < 0) format_err(file_name);
+
+		// every pair takes at least 4 bytes (" u v"), so a larger count is
+		// a broken header and must not be allocated
+		if (static_cast< size_t >(num_of_E) > static_cast< size_t >(end - p) / 4)
+			format_err(file_name);
+
+		edges.resize(num_of_E);
+
+		for (int i = 0; i < num_of_E; ++i) {
+			int u, v;
+			if (!nextInt(p, end, u) || !nextInt(p, end, v)) format_err(file_name);
+			if (u < 0 || u >= num_of_V || v < 0 || v >= num_of_V) format_err(file_name);
+			edges[i] = pii(u, v);
+		}
+	}
+
+public:
+	EdgeListFile(std::string file_name) : num_of_V(0), num_of_E(0) {
+		size_t len;
+		const char* p = map(file_name, len);
+		if (len == 0) format_err(file_name);
+
+		parse(p, p + len, file_name);
+
+		munmap(const_cast< char* >(p), len);
+	}
+
+	// FNV-1a hash of the file bytes, used as the key of cached preprocessing
+	static uint64_t contentHash(std::string file_name) {
+		size_t len;
+		const char* p = map(file_name, len);
+
+		uint64_t h = 14695981039346656037ULL;
+		for (size_t i = 0; i < len; ++i) {
+			h ^= static_cast< unsigned char >(p[i]);
+			h *= 1099511628211ULL;
+		}
+
+		if (len > 0) munmap(const_cast< char* >(p), len);
+		return h;
+	}
+
+	int getNumOfV() const { return num_of_V; }
+	int getNumOfE() const { return num_of_E; }
+
+	const Vec< pii >& getEdges() const { return edges; }
+};
+
+} // namespace hybriddd
+
+#endif // EDGE_LIST_FILE_HPP
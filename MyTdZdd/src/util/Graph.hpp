@@ -7,12 +7,19 @@
 #include <map>
 #include <queue>
 #include <algorithm>
+#include <chrono>
+#include <random>
 
 #include "commons.hpp"
+#include "MateTable.hpp"
 
 namespace hybriddd {
 
+class GraphCache;
+
 class Graph {
+	friend class GraphCache;
+
 public:
 	struct Edge {
 		int v1, v2;
@@ -48,15 +55,42 @@ public:
 		};
 	};
 	
+	// per-level record: remaining degrees of the endpoints and the vertices
+	// joining the frontier before / leaving it after the level (-1 if none)
 	struct AddInfo {
 		int rm1, rm2;
-		USet< int > adj1, adj2;
-		USet< int > frontier;
-		AddInfo() { rm1 = rm2 = -1; }
+		int enter[2], leave[2];
+		int fsize; // frontier size at the level
+		
+		AddInfo() {
+			rm1 = rm2 = -1;
+			enter[0] = enter[1] = leave[0] = leave[1] = -1;
+			fsize = 0;
+		}
+		
+		void addEnter(int v) {
+			if (enter[0] == v) return;
+			enter[enter[0] < 0 ? 0 : 1] = v;
+		}
+		
+		void addLeave(int v) {
+			if (leave[0] == v) return;
+			leave[leave[0] < 0 ? 0 : 1] = v;
+		}
 	};
 	
 	typedef std::pair< int, int > pii;
 	
+	// entry of the adjacency list of v
+	struct Arc {
+		int to;       // neighbor
+		int out, in;  // multiplicity of (v, to) and (to, v) in the input
+		size_t twin;  // entry of v in the list of to
+		
+		Arc() {}
+		Arc(int to, int out, int in) : to(to), out(out), in(in), twin(0) {}
+	};
+	
 	class PiiHash {
 	public:
 		size_t operator() (const pii& p) const {
@@ -68,18 +102,28 @@ protected:
 	bool ordered;
 	size_t num_of_V;
 	size_t max_fsize;
+	
+	// parameters of the "beam" ordering
+	size_t beam_width;
+	double beam_time_limit; // seconds, <= 0 for no limit
 	MyUMap< Edge, size_t, Edge::Hash > lev_of_edge;	
 	MyUMap< pii, size_t, PiiHash > Emap;
 	Vec< pii > asisvec;
 	
+	// compressed sparse row adjacency, arcs of v are [adj_head[v], adj_head[v + 1])
+	Vec< size_t > adj_head;
+	Vec< Arc > arcs;
+	
 protected:
 	Vec< Edge > edges;
 	Vec< AddInfo > addinfo_vec;
 	Vec< size_t > mate_index;
+	MateTable adj_mates; // mate indices of adj1 / adj2 (2 rows per edge)
 	
 public:
-	Graph() : ordered(false) {}
-	Graph(size_t num_of_V) : ordered(false), num_of_V(num_of_V) {}
+	Graph() : ordered(false), beam_width(16), beam_time_limit(0) {}
+	Graph(size_t num_of_V) : ordered(false), num_of_V(num_of_V),
+							 beam_width(16), beam_time_limit(0) {}
 	
 	void addEdge(int v1, int v2) {
 		assert(0 <= v1 && v1 < (int)num_of_V);
@@ -88,22 +132,45 @@ public:
 		asisvec.push_back(pii(v1, v2));
 	}
 	
+	void addEdges(const Vec< pii >& es) {
+		Emap.reserve(Emap.size() + es.size());
+		asisvec.reserve(asisvec.size() + es.size());
+		for (const pii& p : es) addEdge(p.first, p.second);
+	}
+	
 	size_t getNumOfV() const { return num_of_V; }
 	
 	size_t getNumOfE() const { return edges.size(); }
 	
-	Edge getEdge(size_t i) const {
+	const Edge& getEdge(size_t i) const {
 		assert(0 <= i && i < getNumOfE());
 		return edges[i];
 	}
 	
-	AddInfo getAddInfo(size_t i) const {
+	const AddInfo& getAddInfo(size_t i) const {
 		assert(0 <= i && i < getNumOfE());
 		return addinfo_vec[i];
 	}
 	
+	MateRange getAdjMates1(size_t i) const {
+		assert(0 <= i && i < getNumOfE());
+		return adj_mates.row(2 * i);
+	}
+	
+	MateRange getAdjMates2(size_t i) const {
+		assert(0 <= i && i < getNumOfE());
+		return adj_mates.row(2 * i + 1);
+	}
+	
 	size_t getMaxFSize() const { return max_fsize; }
 	
+	double getMeanFSize() const {
+		if (addinfo_vec.empty()) return 0;
+		double sum = 0;
+		for (const AddInfo& a : addinfo_vec) sum += a.fsize;
+		return sum / addinfo_vec.size();
+	}
+	
 	size_t getMateI(int v) const {
 		assert(0 <= v && v < (int)num_of_V);
 		return mate_index[v];
@@ -118,28 +185,221 @@ public:
 public:
 	bool isOrdered() const { return ordered; }
 	
+	// width of the beam and time budget of the "beam" ordering; once the
+	// budget is spent the search continues greedily (width 1).
+	// "beam#k" (k > 0) breaks ties by a random vertex ranking seeded by k
+	void setBeamSearch(size_t width, double time_limit = 0) {
+		beam_width = std::max(width, size_t(1));
+		beam_time_limit = time_limit;
+	}
+	
 	void setOrder(std::string type = "bfs") {
 		assert(Emap.size() > 0);
 		ordered = false;
 		
 		edges.clear();
 		addinfo_vec.clear();
+		adj_mates.clear();
+		
+		setAdjacency();
 		
 		if (type == "dfs") dfsOrdering();
 		else if (type == "greedy") greedyOrdering();
 		else if (type == "as-is") asisOrdering();
+		else if (type.compare(0, 4, "beam") == 0) beamOrdering(beamSeed(type));
 		else bfsOrdering();
 		
 		setMateOrder();
 		ordered = true;
 	}
 	
-private:	
+	// explicit edge order, a permutation of the input edges
+	void setOrder(const Vec< pii >& edge_order) {
+		assert(Emap.size() > 0);
+		assert(edge_order.size() == asisvec.size());
+		ordered = false;
+		
+		edges.clear();
+		addinfo_vec.clear();
+		adj_mates.clear();
+		
+		setAdjacency();
+		
+		edges.reserve(edge_order.size());
+		for (const pii& p : edge_order) {
+			assert(findEdge(p.first, p.second));
+			edges.push_back(Edge(p.first, p.second));
+		}
+		
+		setMateOrder();
+		ordered = true;
+	}
+	
+	// biconnected components (blocks) as lists of input edges. a bridge is a
+	// block of its own, parallel edges stay together and the self-loops of a
+	// vertex form one block. requires the adjacency built by setOrder
+	Vec< Vec< pii > > getBlocks() const {
+		assert(adj_head.size() == num_of_V + 1);
+		
+		const int NONE = -1;
+		Vec< int > disc(num_of_V, NONE), low(num_of_V, 0);
+		Vec< int > block_of_arc(arcs.size(), NONE);
+		Vec< size_t > estack;
+		int num_of_blocks = 0, time = 0;
+		
+		// DFS frame: vertex, arc from the parent, next arc to scan
+		struct Frame { int v; size_t pk, k; };
+		Vec< Frame > frames;
+		
+		for (int r = 0; r < (int)num_of_V; ++r) {
+			if (disc[r] != NONE) continue;
+			disc[r] = low[r] = time++;
+			frames.push_back(Frame{r, arcs.size(), adj_head[r]});
+			
+			while (!frames.empty()) {
+				Frame& f = frames.back();
+				int v = f.v;
+				
+				if (f.k < adj_head[v + 1]) {
+					size_t k = f.k++;
+					int u = arcs[k].to;
+					if (u == v || (f.pk < arcs.size() && k == arcs[f.pk].twin)) continue;
+					
+					if (disc[u] == NONE) {
+						estack.push_back(k);
+						disc[u] = low[u] = time++;
+						frames.push_back(Frame{u, k, adj_head[u]});
+					} else if (disc[u] < disc[v]) {
+						estack.push_back(k);
+						low[v] = std::min(low[v], disc[u]);
+					}
+					continue;
+				}
+				
+				size_t pk = f.pk;
+				frames.pop_back();
+				if (frames.empty()) break;
+				
+				int p = frames.back().v;
+				low[p] = std::min(low[p], low[v]);
+				
+				// p separates the subtree of v: the arcs above pk form a block
+				if (low[v] >= disc[p]) {
+					while (1) {
+						size_t k = estack.back(); estack.pop_back();
+						block_of_arc[k] = block_of_arc[arcs[k].twin] = num_of_blocks;
+						if (k == pk) break;
+					}
+					++num_of_blocks;
+				}
+			}
+		}
+		
+		Vec< Vec< pii > > blocks(num_of_blocks);
+		for (int v = 0; v < (int)num_of_V; ++v) {
+			for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+				const Arc& a = arcs[k];
+				if (a.to < v) continue;
+				
+				// a self-loop has a single (merged) arc
+				if (a.to == v) blocks.push_back(Vec< pii >());
+				Vec< pii >& b = (a.to == v) ? blocks.back() : blocks[block_of_arc[k]];
+				
+				for (int c = 0; c < a.out; ++c) b.push_back(pii(v, a.to));
+				for (int c = 0; c < a.in; ++c) b.push_back(pii(a.to, v));
+			}
+		}
+		
+		return blocks;
+	}
+	
+private:
+	// appends the input edges between v and arcs[k].to, the ones leaving v first
+	void pushEdges(int v, size_t k) {
+		const Arc& a = arcs[k];
+		for (int c = 0; c < a.out; ++c) edges.push_back(Edge(v, a.to));
+		for (int c = 0; c < a.in; ++c) edges.push_back(Edge(a.to, v));
+	}
+	
+	void setAdjacency() {
+		Vec< size_t > cnt(num_of_V + 1, 0);
+		
+		auto it = Emap.begin(), eit = Emap.end();
+		for (; it != eit; ++it) {
+			int u = it->first.first, v = it->first.second;
+			++cnt[u];
+			if (u != v) ++cnt[v];
+		}
+		
+		Vec< size_t > pos(num_of_V + 1, 0);
+		for (size_t v = 0; v < num_of_V; ++v) pos[v + 1] = pos[v] + cnt[v];
+		
+		Vec< Arc > raw(pos[num_of_V]);
+		for (it = Emap.begin(); it != eit; ++it) {
+			int u = it->first.first, v = it->first.second;
+			int c = it->second;
+			raw[pos[u]++] = Arc(v, c, 0);
+			if (u != v) raw[pos[v]++] = Arc(u, 0, c);
+		}
+		
+		// sort each row by neighbor and merge (u, v) with (v, u)
+		arcs.clear();
+		arcs.reserve(raw.size());
+		adj_head.assign(num_of_V + 1, 0);
+		
+		size_t st = 0;
+		for (size_t v = 0; v < num_of_V; ++v) {
+			size_t en = st + cnt[v];
+			std::sort(raw.begin() + st, raw.begin() + en,
+					  [](const Arc& a, const Arc& b) { return a.to < b.to; });
+			
+			for (size_t k = st; k < en; ++k) {
+				if (arcs.size() > adj_head[v] && arcs.back().to == raw[k].to) {
+					arcs.back().out += raw[k].out;
+					arcs.back().in += raw[k].in;
+				} else {
+					arcs.push_back(raw[k]);
+				}
+			}
+			
+			adj_head[v + 1] = arcs.size();
+			st = en;
+		}
+		
+		// rows are sorted, so the arcs into u are met in increasing order of v
+		for (size_t v = 0; v < num_of_V; ++v) pos[v] = adj_head[v];
+		for (size_t v = 0; v < num_of_V; ++v) {
+			for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+				size_t t = pos[arcs[k].to]++;
+				assert(arcs[t].to == (int)v);
+				arcs[k].twin = t;
+			}
+		}
+	}
+	
 	void asisOrdering() { for (pii& p : asisvec) edges.push_back(Edge(p.first, p.second)); }
 	
+	void decDeg(int v, int c, Vec< int >& deg,
+				std::set< pii >& alive, std::set< pii >& frontier,
+				const Vec< bool >& in_frontier) const {
+		if (c == 0) return;
+		
+		alive.erase(pii(deg[v], v));
+		if (in_frontier[v]) frontier.erase(pii(deg[v], v));
+		
+		deg[v] -= c;
+		
+		if (deg[v] > 0) {
+			alive.insert(pii(deg[v], v));
+			if (in_frontier[v]) frontier.insert(pii(deg[v], v));
+		}
+	}
+	
 	void greedyOrdering() {
-		Vec< int > deg(num_of_V + 1, 0);
-		MyUSet< pii, PiiHash > used;
+		Vec< int > deg(num_of_V, 0);
+		Vec< bool > used(arcs.size(), false);
+		Vec< bool > in_frontier(num_of_V, false);
+		Vec< bool > is_new(num_of_V, false);
 		
 		for (pii& p : asisvec) {
 			int u = p.first, v = p.second;
@@ -147,132 +407,348 @@ private:
 			++deg[v];
 		}
 		
-		deg[num_of_V] = int(1e9);
+		// (degree, vertex), so that begin() is the pivot
+		std::set< pii > alive;
+		std::set< pii > frontier;
+		
+		for (int v = 0; v < (int)num_of_V; ++v)
+			if (deg[v] > 0) alive.insert(pii(deg[v], v));
 		
-		std::set< int > frontier;
+		auto take = [&](int u, size_t k) {
+			const Arc& a = arcs[k];
+			pushEdges(u, k);
+			used[k] = used[a.twin] = true;
+			decDeg(u, a.out + a.in, deg, alive, frontier, in_frontier);
+			decDeg(a.to, a.out + a.in, deg, alive, frontier, in_frontier);
+		};
+		
+		auto leave = [&](int v) { if (deg[v] == 0) in_frontier[v] = false; };
+		
+		Vec< int > entered;
+		Vec< std::pair< pii, size_t > > pairs;
 		
 		while (1) {
-			auto it1 = frontier.begin(), eitf = frontier.end();
-			std::set< int > out_v;
+			if (alive.empty()) break;
 			
-			for (; it1 != eitf; ++it1) {
-				int u = *it1;
+			int u = frontier.empty() ? alive.begin()->second
+									 : frontier.begin()->second;
+			
+			// take every remaining edge of the pivot
+			entered.clear();
+			for (size_t k = adj_head[u]; k < adj_head[u + 1]; ++k) {
+				if (used[k]) continue;
 				
-				auto it2 = it1;
-				++it2;
+				int v = arcs[k].to;
+				take(u, k);
 				
-				for (; it2 != eitf; ++it2) {
-					int v = *it2;
-					
-					if (used.count(pii(u, v)) == 0 && findEdge(u, v)) {
-						int cnt = Emap.at(pii(u, v));
-						for (int i = 0; i < cnt; ++i) edges.push_back(Edge(u, v));
-						deg[u] -= cnt;
-						deg[v] -= cnt;
-						used.insert(pii(u, v));
-					}
-					
-					if (used.count(pii(v, u)) == 0 && findEdge(v, u)) {
-						int cnt = Emap.at(pii(v, u));
-						for (int i = 0; i < cnt; ++i) edges.push_back(Edge(v, u));
-						deg[u] -= cnt;
-						deg[v] -= cnt;
-						used.insert(pii(v, u));
-					}
+				if (deg[v] > 0 && !in_frontier[v]) {
+					in_frontier[v] = true;
+					frontier.insert(pii(deg[v], v));
+					is_new[v] = true;
+					entered.push_back(v);
+				}
+				
+				leave(v);
+			}
+			
+			leave(u);
+			
+			// then the edges that now join two frontier vertices,
+			// in lexicographic order of their endpoints
+			pairs.clear();
+			for (int x : entered) {
+				for (size_t k = adj_head[x]; k < adj_head[x + 1]; ++k) {
+					int y = arcs[k].to;
+					if (used[k] || y == x || !in_frontier[y]) continue;
+					if (is_new[y] && y < x) continue;
 					
-					if (deg[u] == 0) out_v.insert(u);
-					if (deg[v] == 0) out_v.insert(v);
+					if (x < y) pairs.push_back(std::make_pair(pii(x, y), k));
+					else pairs.push_back(std::make_pair(pii(y, x), arcs[k].twin));
 				}
 			}
 			
-			for (int v : out_v) frontier.erase(v);
+			for (int x : entered) is_new[x] = false;
 			
-			int piv = num_of_V;
+			std::sort(pairs.begin(), pairs.end());
 			
-			if (frontier.size() == 0) {
-				for (int v = 0; v < (int)num_of_V; ++v)
-					if (deg[v] > 0 && deg[piv] > deg[v]) piv = v;
-				if (piv == (int)num_of_V) break;
-			} else {
-				auto itf = frontier.begin(), eitf = frontier.end();
-				for (; itf != eitf; ++itf) {
-					int x = *itf;
-					if (deg[piv] > deg[x]) piv = x;
-				}
+			for (auto& p : pairs) take(p.first.first, p.second);
+			for (auto& p : pairs) {
+				leave(p.first.first);
+				leave(p.first.second);
 			}
+		}
+	}
+	
+	// partial vertex order of the beam search; the order itself is a path
+	// in the tree of placements, so states share their common prefixes
+	struct BeamState {
+		int node;            // last placement in the tree
+		int cur, maxf;       // frontier size now / so far
+		long long sum;       // sum of frontier sizes
+		uint64_t hash;       // xor of the keys of the placed vertices
+	};
+	
+	struct BeamNode {
+		int parent, v, depth;
+	};
+	
+	// placements of the state at node, updated by walking the tree
+	struct BeamScratch {
+		int node;
+		Vec< int > rem;      // neighbors not placed yet
+		Vec< bool > placed;
+		Vec< int > open;     // placed vertices with rem > 0
+		Vec< int > open_pos; // position in open, -1 if not there
+		Vec< int > path;
+	};
+	
+	struct BeamMove {
+		int maxf, cur;
+		long long sum;
+		size_t parent;
+		int v, r;     // vertex and its tie-break rank
+		uint64_t hash;
+		
+		bool operator < (const BeamMove& m) const {
+			if (maxf != m.maxf) return maxf < m.maxf;
+			if (cur != m.cur) return cur < m.cur;
+			if (sum != m.sum) return sum < m.sum;
+			if (parent != m.parent) return parent < m.parent;
+			return r < m.r;
+		}
+	};
+	
+	static void openVertex(BeamScratch& s, int v) {
+		s.open_pos[v] = s.open.size();
+		s.open.push_back(v);
+	}
+	
+	static void closeVertex(BeamScratch& s, int v) {
+		int last = s.open.back();
+		s.open[s.open_pos[v]] = last;
+		s.open_pos[last] = s.open_pos[v];
+		s.open.pop_back();
+		s.open_pos[v] = -1;
+	}
+	
+	void placeVertex(BeamScratch& s, int v) const {
+		s.placed[v] = true;
+		for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+			int u = arcs[k].to;
+			if (u == v) continue;
+			if (--s.rem[u] == 0 && s.placed[u]) closeVertex(s, u);
+		}
+		if (s.rem[v] > 0) openVertex(s, v);
+	}
+	
+	void unplaceVertex(BeamScratch& s, int v) const {
+		if (s.open_pos[v] >= 0) closeVertex(s, v);
+		for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+			int u = arcs[k].to;
+			if (u == v) continue;
+			if (s.rem[u]++ == 0 && s.placed[u]) openVertex(s, u);
+		}
+		s.placed[v] = false;
+	}
+	
+	// moves the scratch state to a node through their common ancestor
+	void moveScratch(BeamScratch& s, const Vec< BeamNode >& tree, int node) const {
+		int a = s.node, b = node;
+		s.path.clear();
+		while (tree[a].depth > tree[b].depth) {
+			unplaceVertex(s, tree[a].v);
+			a = tree[a].parent;
+		}
+		while (tree[b].depth > tree[a].depth) {
+			s.path.push_back(b);
+			b = tree[b].parent;
+		}
+		while (a != b) {
+			unplaceVertex(s, tree[a].v);
+			a = tree[a].parent;
+			s.path.push_back(b);
+			b = tree[b].parent;
+		}
+		for (size_t i = s.path.size(); i-- > 0;) placeVertex(s, tree[s.path[i]].v);
+		s.node = node;
+	}
+	
+	// k of "beam#k", 0 for plain "beam"
+	static unsigned beamSeed(const std::string& type) {
+		if (type.size() <= 5 || type[4] != '#' || !isnumber(type.substr(5))) return 0;
+		return std::stoul(type.substr(5));
+	}
+	
+	// places vertices one by one keeping the best beam_width partial orders
+	// ranked by (max frontier, current frontier, frontier sum), then emits the
+	// edges of each vertex towards the vertices placed before it
+	void beamOrdering(unsigned seed = 0) {
+		auto start = std::chrono::steady_clock::now();
+		size_t width = beam_width;
+		
+		std::mt19937_64 rng(0x5eed);
+		Vec< uint64_t > key(num_of_V);
+		for (size_t v = 0; v < num_of_V; ++v) key[v] = rng();
+		
+		Vec< int > rank(num_of_V);
+		for (int v = 0; v < (int)num_of_V; ++v) rank[v] = v;
+		if (seed > 0) {
+			std::mt19937_64 shuffle_rng(seed);
+			std::shuffle(rank.begin(), rank.end(), shuffle_rng);
+		}
+		
+		// start of a new component: vertices of small degree first
+		Vec< int > seeds;
+		for (int v = 0; v < (int)num_of_V; ++v)
+			if (adj_head[v] < adj_head[v + 1]) seeds.push_back(v);
+		size_t num_of_placed = seeds.size();
+		std::sort(seeds.begin(), seeds.end(), [&](int a, int b) {
+			size_t da = adj_head[a + 1] - adj_head[a], db = adj_head[b + 1] - adj_head[b];
+			return da != db ? da < db : rank[a] < rank[b];
+		});
+		
+		// the root of the tree places nothing
+		Vec< BeamNode > tree;
+		tree.reserve(num_of_placed * std::min(width, size_t(4)) + 1);
+		tree.push_back(BeamNode{-1, -1, 0});
+		
+		BeamScratch s;
+		s.node = 0;
+		s.rem.assign(num_of_V, 0);
+		s.placed.assign(num_of_V, false);
+		s.open_pos.assign(num_of_V, -1);
+		for (size_t v = 0; v < num_of_V; ++v) {
+			for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k)
+				if (arcs[k].to != (int)v) ++s.rem[v];
+		}
+		
+		Vec< BeamState > beam(1, BeamState{0, 0, 0, 0, 0}), next;
+		Vec< BeamMove > moves;
+		Vec< int > stamp(num_of_V, -1), cand;
+		USet< uint64_t > seen;
+		int round = 0;
+		
+		for (size_t step = 0; step < num_of_placed; ++step) {
+			moves.clear();
 			
-			int u = piv;
-			for (int v = 0; v < (int)num_of_V; ++v) {				
-				if (used.count(pii(u, v)) == 0 && findEdge(u, v)) {
-					frontier.insert(v);
-					int cnt = Emap.at(pii(u, v));	
-					for (int i = 0; i < cnt; ++i) edges.push_back(Edge(u, v));
-					deg[u] -= cnt;
-					deg[v] -= cnt;
-					used.insert(pii(u, v));
+			for (size_t p = 0; p < beam.size(); ++p) {
+				const BeamState& b = beam[p];
+				moveScratch(s, tree, b.node);
+				++round;
+				cand.clear();
+				
+				for (int u : s.open) {
+					for (size_t k = adj_head[u]; k < adj_head[u + 1]; ++k) {
+						int w = arcs[k].to;
+						if (s.placed[w] || stamp[w] == round) continue;
+						stamp[w] = round;
+						cand.push_back(w);
+					}
 				}
 				
-				if (used.count(pii(v, u)) == 0 && findEdge(v, u)) {
-					frontier.insert(v);
-					int cnt = Emap.at(pii(v, u));
-					for (int i = 0; i < cnt; ++i) edges.push_back(Edge(v, u));
-					deg[u] -= cnt;
-					deg[v] -= cnt;
-					used.insert(pii(v, u));
+				if (cand.empty()) {
+					for (int v : seeds) {
+						if (s.placed[v]) continue;
+						cand.push_back(v);
+						if (cand.size() >= width) break;
+					}
 				}
 				
-				if (deg[u] == 0) frontier.erase(u);
-				if (deg[v] == 0) frontier.erase(v);
+				for (int v : cand) {
+					int closes = 0;
+					for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+						int u = arcs[k].to;
+						if (u != v && s.placed[u] && s.rem[u] == 1) ++closes;
+					}
+					
+					BeamMove m;
+					m.cur = b.cur + (s.rem[v] > 0 ? 1 : 0) - closes;
+					m.maxf = std::max(b.maxf, b.cur + 1);
+					m.sum = b.sum + m.cur;
+					m.parent = p;
+					m.v = v;
+					m.r = rank[v];
+					m.hash = b.hash ^ key[v];
+					moves.push_back(m);
+				}
+			}
+			
+			// keep the best move for each set of placed vertices; only
+			// the kept ones become nodes of the tree. moves are sorted
+			// lazily, since only the first few are looked at
+			seen.clear();
+			next.clear();
+			size_t sorted = 0;
+			for (size_t i = 0; i < moves.size() && next.size() < width; ++i) {
+				if (i == sorted) {
+					sorted = std::min(moves.size(), std::max(2 * sorted, 2 * width));
+					std::partial_sort(moves.begin() + i, moves.begin() + sorted, moves.end());
+				}
+				const BeamMove& m = moves[i];
+				if (!seen.insert(m.hash).second) continue;
+				int parent = beam[m.parent].node;
+				tree.push_back(BeamNode{parent, m.v, tree[parent].depth + 1});
+				next.push_back(BeamState{int(tree.size()) - 1, m.cur, m.maxf, m.sum, m.hash});
+			}
+			beam.swap(next);
+			
+			if (width > 1 && beam_time_limit > 0) {
+				std::chrono::duration< double > el = std::chrono::steady_clock::now() - start;
+				if (el.count() > beam_time_limit) width = 1;
+			}
+		}
+		
+		Vec< int > order;
+		order.reserve(num_of_placed);
+		for (int x = beam.front().node; x != 0; x = tree[x].parent) order.push_back(tree[x].v);
+		std::reverse(order.begin(), order.end());
+		
+		Vec< int > pos(num_of_V, -1), last(num_of_V, -1);
+		for (size_t i = 0; i < order.size(); ++i) pos[order[i]] = i;
+		for (int v : order) {
+			for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k)
+				last[v] = std::max(last[v], pos[arcs[k].to]);
+		}
+		
+		// edges to the neighbors that leave the frontier go first
+		Vec< std::pair< pii, size_t > > es;
+		for (int v : order) {
+			es.clear();
+			for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+				int u = arcs[k].to;
+				if (pos[u] > pos[v]) continue;
+				int stay = (u != v && last[u] != pos[v]) ? 1 : 0;
+				es.push_back(std::make_pair(pii(stay, pos[u]), k));
 			}
+			std::sort(es.begin(), es.end());
+			for (auto& e : es) pushEdges(v, e.second);
 		}
 	}
 	
-	void dfs(int v, Vec< bool >& vis, MyUSet< pii, PiiHash >& used) {
+	void dfs(int v, Vec< bool >& vis, Vec< bool >& used) {
 		if (vis[v]) return;
 		vis[v] = true;
 		
-		for (int u = 0; u < (int)num_of_V; ++u) {
-			if (used.count(pii(u, v))) continue;
-			
-			if (findEdge(u, v)) {
-				int cnt = Emap.at(pii(u, v));
-				for (int i = 0; i < cnt; ++i) edges.push_back(Edge(u, v));
-			}
-			
-			if (findEdge(v, u)) {
-				int cnt = Emap.at(pii(v, u));
-				for (int i = 0; i < cnt; ++i) edges.push_back(Edge(v, u));
-			}
+		for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+			if (used[k]) continue;
 			
-			used.insert(pii(u, v));
-			used.insert(pii(v, u));
+			int u = arcs[k].to;
+			pushEdges(u, arcs[k].twin);
+			used[k] = used[arcs[k].twin] = true;
 			
-			if (isAdj(u, v)) dfs(u, vis, used);
+			dfs(u, vis, used);
 		}
 	}
 	
 	void dfsOrdering() {
 		Vec< bool > vis(num_of_V, false);
-		MyUSet< pii, PiiHash > used;
+		Vec< bool > used(arcs.size(), false);
 		for (int v = 0; v < (int)num_of_V; ++v) dfs(v, vis, used);
 	}
 	
 	void bfsOrdering() {
-		Vec< Vec< int > > adjlist(num_of_V);
-		
-		auto it = Emap.begin(), eit = Emap.end();
-		for (; it != eit; ++it) {
-			pii p = (*it).first;
-			int u = p.first, v = p.second;
-			adjlist[u].push_back(v);
-			adjlist[v].push_back(u);
-		}
-		
-		for (size_t v = 0; v < num_of_V; ++v)
-			std::sort(adjlist[v].begin(), adjlist[v].end());
-		
 		Vec< bool > vis(num_of_V, false);
-		MyUSet< pii, PiiHash > used;
+		Vec< bool > used(arcs.size(), false);
 		
 		for (int u = 0; u < (int)num_of_V; ++u) {
 			if (vis[u]) continue;
@@ -286,26 +762,15 @@ private:
 				if (vis[v]) continue;
 				vis[v] = true;
 				
-				size_t adjnum = adjlist[v].size();
-				for (size_t i = 0; i < adjnum; ++i) {
-					int ui = adjlist[v][i];
+				for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+					int ui = arcs[k].to;
 					
 					if (!vis[ui]) que.push(ui);
 					
-					if (used.count(pii(ui, v))) continue;
-					
-					if (findEdge(ui, v)) {
-						int cnt = Emap.at(pii(ui, v));
-						for (int i = 0; i < cnt; ++i) edges.push_back(Edge(ui, v));
-					}
-					
-					if (findEdge(v, ui)) {
-						int cnt = Emap.at(pii(v, ui));
-						for (int i = 0; i < cnt; ++i) edges.push_back(Edge(v, ui));
-					}
+					if (used[k]) continue;
 					
-					used.insert(pii(ui, v));
-					used.insert(pii(v, ui));
+					pushEdges(ui, arcs[k].twin);
+					used[k] = used[arcs[k].twin] = true;
 				}
 			}
 		}
@@ -316,20 +781,20 @@ private:
 		
 		Vec< int > deg(num_of_V, 0);
 		Vec< USet< int > > adjv(num_of_V, USet< int >());
-		USet< int > frontier;
+		Vec< bool > in_frontier(num_of_V, false);
+		int fsize = 0;
 		
-		auto it = Emap.begin(), eit = Emap.end();
-		for (; it != eit; ++it) {
-			pii p = (*it).first;
-			int u = p.first, v = p.second;
-			++deg[u];
-			++deg[v];
+		for (size_t i = 0; i < num_of_E; ++i) {
+			++deg[edges[i].v1];
+			++deg[edges[i].v2];
 		}
 		
 		mate_index.assign(num_of_V, num_of_V + 1);
 		std::priority_queue< size_t, Vec< size_t >, std::greater< size_t > > que;
 		for (size_t i = 0; i < num_of_V; ++i) que.push(i);
 		
+		addinfo_vec.reserve(num_of_E);
+		
 		for (size_t i = 0; i < num_of_E; ++i) {
 			Edge& e = edges[i];
 			AddInfo addinfo;
@@ -337,37 +802,58 @@ private:
 			--deg[e.v1];
 			--deg[e.v2];
 			
-			frontier.insert(e.v1);
-			frontier.insert(e.v2);
+			if (!in_frontier[e.v1]) {
+				in_frontier[e.v1] = true;
+				addinfo.addEnter(e.v1);
+				++fsize;
+			}
+			
+			if (!in_frontier[e.v2]) {
+				in_frontier[e.v2] = true;
+				addinfo.addEnter(e.v2);
+				++fsize;
+			}
 			
 			addinfo.rm1 = deg[e.v1];
 			addinfo.rm2 = deg[e.v2];
-			addinfo.adj1 = adjv[e.v1];
-			addinfo.adj2 = adjv[e.v2];
-			addinfo.frontier = frontier;
+			addinfo.fsize = fsize;
 			
-			addinfo_vec.push_back(addinfo);
+			// neighbors of the endpoints are in the frontier, so their
+			// mate indices are already fixed
+			adj_mates.addRow(adjv[e.v1], mate_index);
+			adj_mates.addRow(adjv[e.v2], mate_index);
 			
 			adjv[e.v1].insert(e.v2);
 			adjv[e.v2].insert(e.v1);
 			
+			// a self-loop enters / leaves its vertex once, through v1
+			bool loop = (e.v1 == e.v2);
+			
 			if (mate_index[e.v1] == num_of_V + 1) e.in1 = true;
-			if (mate_index[e.v2] == num_of_V + 1) e.in2 = true;
+			if (mate_index[e.v2] == num_of_V + 1 && !loop) e.in2 = true;
 			
 			if (deg[e.v1] == 0) {
 				e.out1 = true;
-				frontier.erase(e.v1);
-				for (int u = 0; u < (int)num_of_V; ++u)
-					adjv[u].erase(e.v1);
+				addinfo.addLeave(e.v1);
+				for (size_t k = adj_head[e.v1]; k < adj_head[e.v1 + 1]; ++k)
+					adjv[arcs[k].to].erase(e.v1);
 			}
 			
-			if (deg[e.v2] == 0) {
+			if (deg[e.v2] == 0 && !loop) {
 				e.out2 = true;
-				frontier.erase(e.v2);
-				for (int u = 0; u < (int)num_of_V; ++u)
-					adjv[u].erase(e.v2);
+				addinfo.addLeave(e.v2);
+				for (size_t k = adj_head[e.v2]; k < adj_head[e.v2 + 1]; ++k)
+					adjv[arcs[k].to].erase(e.v2);
+			}
+			
+			for (int j = 0; j < 2; ++j) {
+				if (addinfo.leave[j] < 0) continue;
+				in_frontier[addinfo.leave[j]] = false;
+				--fsize;
 			}
 			
+			addinfo_vec.push_back(addinfo);
+			
 			if (e.in1) {
 				size_t index = que.top(); que.pop();
 				e.i1 = mate_index[e.v1] = index;
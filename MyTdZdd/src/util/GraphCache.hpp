@@ -0,0 +1,356 @@
+#ifndef GRAPH_CACHE_HPP
+#define GRAPH_CACHE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "commons.hpp"
+#include "HybridGraph.hpp"
+
+namespace hybriddd {
+
+// binary image of an ordered HybridGraph (edge order, mate indices, in/out
+// flags, item tables), keyed by the content hash of the source graph file
+// and the ordering name.
+// layout: Header, then every array as (uint64 byte length, raw bytes padded
+// to 8 bytes), so that each array is aligned in the mapped file. the header
+// holds a checksum of the rest, and every index is range-checked on load,
+// so a broken image is a cache miss
+class GraphCache {
+private:
+	static const uint32_t MAGIC = 0x47445948; // "HYDG"
+	static const uint32_t VERSION = 2;
+
+	struct Header { // 80 bytes, keeps the arrays 8-byte aligned
+		uint32_t magic;
+		uint32_t version;
+		uint32_t size_of_size_t;
+		uint32_t size_of_edge;  // record sizes, so that a layout change
+		uint32_t size_of_item;  // can't load stale images
+		uint32_t size_of_addinfo;
+		uint32_t size_of_arc;
+		uint32_t reserved;
+		uint64_t hash;
+		uint64_t checksum;      // of everything after the header
+		char order[32];
+	};
+
+	static_assert(sizeof(Header) % 8 == 0, "unaligned header");
+	static_assert(std::is_trivially_copyable< Graph::Edge >::value, "Edge must be POD");
+	static_assert(std::is_trivially_copyable< Graph::AddInfo >::value, "AddInfo must be POD");
+	static_assert(std::is_trivially_copyable< Graph::Arc >::value, "Arc must be POD");
+	static_assert(std::is_trivially_copyable< HybridGraph::Item >::value, "Item must be POD");
+
+	static size_t padded(size_t len) { return (len + 7) & ~size_t(7); }
+
+	// checksum of 8-byte words, fed in the order they are written
+	class Checksum {
+	private:
+		uint64_t h;
+
+	public:
+		Checksum() : h(0x243F6A8885A308D3ULL) {}
+
+		void add(const void* data, size_t len) {
+			assert(len % 8 == 0);
+			const char* p = static_cast< const char* >(data);
+			for (size_t k = 0; k < len; k += 8) {
+				uint64_t w;
+				memcpy(&w, p + k, 8);
+				h = ((h << 31) | (h >> 33)) ^ w;
+				h *= 0x9E3779B97F4A7C15ULL;
+			}
+		}
+
+		uint64_t value() const { return h ^ (h >> 29); }
+	};
+
+	template < typename T >
+	static bool put(FILE* fp, Checksum& sum, const Vec< T >& v) {
+		static_assert(alignof(T) <= 8, "unaligned section");
+
+		uint64_t len = v.size() * sizeof(T);
+		if (fwrite(&len, sizeof(len), 1, fp) != 1) return false;
+		sum.add(&len, sizeof(len));
+		if (len == 0) return true;
+
+		// the tail is padded with zeros
+		size_t body = len & ~uint64_t(7);
+		const char* p = reinterpret_cast< const char* >(v.data());
+		char tail[8] = {};
+		memcpy(tail, p + body, len - body);
+		sum.add(p, body);
+		if (body > 0 && fwrite(p, body, 1, fp) != 1) return false;
+		if (len == body) return true;
+		sum.add(tail, 8);
+		return fwrite(tail, 8, 1, fp) == 1;
+	}
+
+	// reads the arrays back from the mapped file
+	class Reader {
+	private:
+		const char* p;
+		const char* end;
+
+	public:
+		Reader(const char* p_, const char* end_) : p(p_), end(end_) {}
+
+		template < typename T >
+		bool get(Vec< T >& v) {
+			uint64_t len;
+			if (size_t(end - p) < sizeof(len)) return false;
+			memcpy(&len, p, sizeof(len));
+			p += sizeof(len);
+
+			if (len % sizeof(T) != 0 || size_t(end - p) < padded(len)) return false;
+			const T* first = reinterpret_cast< const T* >(p);
+			v.assign(first, first + len / sizeof(T));
+			p += padded(len);
+			return true;
+		}
+
+		bool atEnd() const { return p == end; }
+	};
+
+	static bool setHeader(Header& h, uint64_t hash, const std::string& order) {
+		if (order.size() >= sizeof(h.order)) return false;
+		memset(&h, 0, sizeof(h));
+		h.magic = MAGIC;
+		h.version = VERSION;
+		h.size_of_size_t = sizeof(size_t);
+		h.size_of_edge = sizeof(Graph::Edge);
+		h.size_of_item = sizeof(HybridGraph::Item);
+		h.size_of_addinfo = sizeof(Graph::AddInfo);
+		h.size_of_arc = sizeof(Graph::Arc);
+		h.hash = hash;
+		memcpy(h.order, order.c_str(), order.size());
+		return true;
+	}
+
+	static bool read(HybridGraph& g, Reader& r) {
+		Vec< uint64_t > scalars;
+		Vec< MateTable* > tables = {&g.adj_mates, &g.adj_mates_bf, &g.adj_mates_af};
+
+		if (!r.get(scalars) || scalars.size() != 2) return false;
+		g.num_of_V = scalars[0];
+		g.max_fsize = scalars[1];
+
+		bool ok = r.get(g.asisvec) && r.get(g.adj_head) && r.get(g.arcs) &&
+				  r.get(g.edges) && r.get(g.addinfo_vec) && r.get(g.mate_index) &&
+				  r.get(g.items_bf) && r.get(g.items_af) &&
+				  r.get(g.addinfo_bf) && r.get(g.addinfo_af) &&
+				  r.get(g.pos_of_vertex_bf) && r.get(g.pos_of_edge_bf) &&
+				  r.get(g.pos_of_vertex_af) && r.get(g.pos_of_edge_af);
+		for (MateTable* t : tables) ok = ok && r.get(t->head) && r.get(t->body);
+		if (!ok || !r.atEnd()) return false;
+
+		size_t V = g.num_of_V, E = g.edges.size();
+		if (g.adj_head.size() != V + 1 || g.mate_index.size() != V ||
+			g.addinfo_vec.size() != E || g.adj_mates.numOfRows() != 2 * E ||
+			g.items_bf.size() != V + E || g.items_af.size() != V + E ||
+			g.addinfo_bf.size() != V + E || g.addinfo_af.size() != V + E ||
+			g.pos_of_vertex_bf.size() != V || g.pos_of_vertex_af.size() != V ||
+			g.pos_of_edge_bf.size() != E || g.pos_of_edge_af.size() != E ||
+			g.adj_mates_bf.numOfRows() != 2 * (V + E) ||
+			g.adj_mates_af.numOfRows() != 2 * (V + E)) return false;
+
+		for (const MateTable* t : tables) {
+			if (t->head.empty() || t->head.front() != 0 || t->head.back() != t->body.size())
+				return false;
+			for (size_t r = 0; r + 1 < t->head.size(); ++r)
+				if (t->head[r] > t->head[r + 1]) return false;
+			if (!mates(g, t->body)) return false;
+		}
+
+		return valid(g);
+	}
+
+	static bool vertex(const Graph& g, int v) { return 0 <= v && size_t(v) < g.num_of_V; }
+
+	static bool mate(const Graph& g, size_t i) { return i < g.max_fsize; }
+
+	static bool mates(const Graph& g, const Vec< size_t >& is) {
+		for (size_t i : is) if (!mate(g, i)) return false;
+		return true;
+	}
+
+	static bool valid(const Graph& g, const Graph::AddInfo& a) {
+		if (a.rm1 < -1 || a.rm2 < -1 || a.fsize < 0 || size_t(a.fsize) > g.num_of_V)
+			return false;
+		for (int j = 0; j < 2; ++j) {
+			if (a.enter[j] != -1 && !vertex(g, a.enter[j])) return false;
+			if (a.leave[j] != -1 && !vertex(g, a.leave[j])) return false;
+		}
+		return true;
+	}
+
+	static bool valid(const HybridGraph& g, const Vec< HybridGraph::Item >& items) {
+		for (const HybridGraph::Item& it : items) {
+			if (it.isvertex) {
+				if (!vertex(g, it.v) || !mate(g, it.i)) return false;
+			} else {
+				if (!vertex(g, it.v1) || !vertex(g, it.v2) || !mate(g, it.i1) ||
+					!mate(g, it.i2) || it.eid >= g.edges.size()) return false;
+			}
+		}
+		return true;
+	}
+
+	static bool valid(const Vec< size_t >& pos, size_t n) {
+		for (size_t p : pos) if (p >= n) return false;
+		return true;
+	}
+
+	// every vertex id, mate index and position is used to index arrays
+	static bool valid(const HybridGraph& g) {
+		size_t V = g.num_of_V, E = g.edges.size();
+		if (g.max_fsize > V) return false;
+
+		for (const Graph::pii& p : g.asisvec)
+			if (!vertex(g, p.first) || !vertex(g, p.second)) return false;
+
+		if (g.adj_head.front() != 0 || g.adj_head.back() != g.arcs.size()) return false;
+		for (size_t v = 0; v < V; ++v)
+			if (g.adj_head[v] > g.adj_head[v + 1]) return false;
+		for (const Graph::Arc& a : g.arcs)
+			if (!vertex(g, a.to) || a.twin >= g.arcs.size()) return false;
+
+		for (const Graph::Edge& e : g.edges)
+			if (!vertex(g, e.v1) || !vertex(g, e.v2) || !mate(g, e.i1) || !mate(g, e.i2))
+				return false;
+		for (size_t i : g.mate_index)
+			if (!mate(g, i) && i != V + 1) return false;
+
+		for (const Graph::AddInfo& a : g.addinfo_vec) if (!valid(g, a)) return false;
+		for (const Graph::AddInfo& a : g.addinfo_bf) if (!valid(g, a)) return false;
+		for (const Graph::AddInfo& a : g.addinfo_af) if (!valid(g, a)) return false;
+
+		return valid(g, g.items_bf) && valid(g, g.items_af) &&
+			   valid(g.pos_of_vertex_bf, V + E) && valid(g.pos_of_edge_bf, V + E) &&
+			   valid(g.pos_of_vertex_af, V + E) && valid(g.pos_of_edge_af, V + E);
+	}
+
+public:
+	// name of an ordering in the cache; the beam ordering also depends on
+	// its width and time limit
+	static std::string key(const std::string& order, size_t beam_width,
+						   double beam_time_limit) {
+		if (order.compare(0, 4, "beam") != 0) return order;
+		std::string k = order + "-w" + std::to_string(beam_width);
+		if (beam_time_limit > 0) {
+			char buf[32];
+			snprintf(buf, sizeof(buf), "-t%g", beam_time_limit);
+			k += buf;
+		}
+		return k;
+	}
+
+	static std::string path(const std::string& dir, uint64_t hash, const std::string& order) {
+		char buf[17];
+		snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+		return dir + "/" + buf + "-" + order + ".hydg";
+	}
+
+	// false if the file is missing, stale or broken; g is left untouched then
+	static bool load(HybridGraph& g, const std::string& file_name,
+					 uint64_t hash, const std::string& order) {
+		Header expect;
+		if (!setHeader(expect, hash, order)) return false;
+
+		int fd = open(file_name.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+			close(fd);
+			return false;
+		}
+
+		size_t len = st.st_size;
+		void* addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (addr == MAP_FAILED) return false;
+
+		madvise(addr, len, MADV_SEQUENTIAL);
+
+		const char* p = static_cast< const char* >(addr);
+		Header found;
+		memcpy(&found, p, sizeof(Header));
+		expect.checksum = found.checksum;
+		bool ok = (memcmp(&found, &expect, sizeof(Header)) == 0) &&
+				  (len - sizeof(Header)) % 8 == 0;
+
+		if (ok) {
+			Checksum sum;
+			sum.add(p + sizeof(Header), len - sizeof(Header));
+			ok = (sum.value() == found.checksum);
+		}
+
+		HybridGraph h;
+		if (ok) {
+			Reader r(p + sizeof(Header), p + len);
+			ok = read(h, r);
+		}
+
+		munmap(addr, len);
+		if (!ok) return false;
+
+		// the edge map is not stored, it is rebuilt from the input order
+		Vec< Graph::pii > es;
+		es.swap(h.asisvec);
+		h.addEdges(es);
+
+		h.ordered = true;
+		h.set_end = true;
+		g = std::move(h);
+		return true;
+	}
+
+	// writes to a temporary file and renames it, so that concurrent readers
+	// never see a partial image. returns false if the cache can't be written
+	static bool save(const HybridGraph& g, const std::string& file_name,
+					 uint64_t hash, const std::string& order) {
+		assert(g.isOrdered());
+
+		Header h;
+		if (!setHeader(h, hash, order)) return false;
+
+		std::string tmp = file_name + ".tmp" + std::to_string(getpid());
+		FILE* fp = fopen(tmp.c_str(), "wb");
+		if (fp == NULL) return false;
+
+		Vec< uint64_t > scalars = {uint64_t(g.num_of_V), uint64_t(g.max_fsize)};
+		const MateTable* tables[] = {&g.adj_mates, &g.adj_mates_bf, &g.adj_mates_af};
+		Checksum sum;
+
+		// the header is written again with the checksum at the end
+		bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 && put(fp, sum, scalars) &&
+				  put(fp, sum, g.asisvec) && put(fp, sum, g.adj_head) && put(fp, sum, g.arcs) &&
+				  put(fp, sum, g.edges) && put(fp, sum, g.addinfo_vec) &&
+				  put(fp, sum, g.mate_index) &&
+				  put(fp, sum, g.items_bf) && put(fp, sum, g.items_af) &&
+				  put(fp, sum, g.addinfo_bf) && put(fp, sum, g.addinfo_af) &&
+				  put(fp, sum, g.pos_of_vertex_bf) && put(fp, sum, g.pos_of_edge_bf) &&
+				  put(fp, sum, g.pos_of_vertex_af) && put(fp, sum, g.pos_of_edge_af);
+		for (const MateTable* t : tables)
+			ok = ok && put(fp, sum, t->head) && put(fp, sum, t->body);
+
+		h.checksum = sum.value();
+		ok = ok && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, fp) == 1;
+
+		ok = (fclose(fp) == 0) && ok;
+		if (ok) ok = (rename(tmp.c_str(), file_name.c_str()) == 0);
+		if (!ok) remove(tmp.c_str());
+		return ok;
+	}
+};
+
+} // namespace hybriddd
+
+#endif // GRAPH_CACHE_HPP
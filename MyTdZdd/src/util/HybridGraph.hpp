@@ -6,6 +6,8 @@
 namespace hybriddd {
 
 class HybridGraph : public Graph {
+	friend class GraphCache;
+
 public:
 	struct Item {
 		int v1, v2;
@@ -16,20 +18,24 @@ public:
 		int v;
 		size_t i;
 		
+		size_t eid; // position of the edge in the edge order
+		
 		Item() {}
 		
 		Item(int v1, int v2) : v1(v1), v2(v2) {
 			i1 = i2 = 0;
 			in1 = out1 = in2 = out2 = false;
 			isvertex = false;
+			eid = size_t(1e9);
 		}
 		
 		Item(int v) : v(v) {
 			isvertex = true;
 			i = size_t(1e9);
+			eid = size_t(1e9);
 		}
 		
-		Item(Edge& e) {
+		Item(const Edge& e, size_t eid) : eid(eid) {
 			v1 = e.v1; v2 = e.v2;
 			i1 = e.i1; i2 = e.i2;
 			in1 = e.in1; out1 = e.out1;
@@ -69,20 +75,7 @@ public:
 		};
 	};	
 	
-	struct AddInfoHV {
-		int rm1, rm2;
-		USet< int > adj1, adj2;
-		USet< int > frontier;
-		USet< int > adj;
-		
-		AddInfoHV() { rm1 = rm2 = -1; }
-		
-		AddInfoHV(const AddInfo& a) {
-			rm1 = a.rm1; rm2 = a.rm2;
-			adj1 = a.adj1; adj2 = a.adj2;
-			frontier = a.frontier;
-		}
-	};
+	typedef AddInfo AddInfoHV;
 	
 protected:
 	bool set_end;
@@ -93,8 +86,14 @@ protected:
 	Vec< AddInfoHV > addinfo_bf;
 	Vec< AddInfoHV > addinfo_af;
 	
-	MyUMap< Item, size_t, Item::Hash > lev_of_item_bf;
-	MyUMap< Item, size_t, Item::Hash > lev_of_item_af;
+	// positions in items_bf / items_af
+	Vec< size_t > pos_of_vertex_bf, pos_of_edge_bf;
+	Vec< size_t > pos_of_vertex_af, pos_of_edge_af;
+	
+	// mate indices of adj (vertex items) or adj1 / adj2 (edge items),
+	// 2 rows per item
+	MateTable adj_mates_bf;
+	MateTable adj_mates_af;
 	
 public:
 	HybridGraph() : set_end(false) {}
@@ -102,180 +101,204 @@ public:
 	
 	size_t getNumOfI() const { return items_af.size(); }
 	
-	Item getItemBf(size_t i) const {
+	const Item& getItemBf(size_t i) const {
 		assert(0 <= i && i < getNumOfI());
 		return items_bf[i];
 	}
 	
-	Item getItemAf(size_t i) const {
+	const Item& getItemAf(size_t i) const {
 		assert(0 <= i && i < getNumOfI());
 		return items_af[i];
 	}
 	
-	AddInfoHV getAddInfoBf(size_t i) const {
+	const AddInfoHV& getAddInfoBf(size_t i) const {
 		assert(0 <= i && i < getNumOfI());
 		return addinfo_bf[i];
 	}
 	
-	AddInfoHV getAddInfoAf(size_t i) const {
+	const AddInfoHV& getAddInfoAf(size_t i) const {
 		assert(0 <= i && i < getNumOfI());
 		return addinfo_af[i];
 	}
 	
+	MateRange getAdjMatesBf(size_t i) const {
+		assert(0 <= i && i < getNumOfI());
+		assert(items_bf[i].isvertex);
+		return adj_mates_bf.row(2 * i);
+	}
+	
+	MateRange getAdjMates1Bf(size_t i) const {
+		assert(0 <= i && i < getNumOfI());
+		assert(!items_bf[i].isvertex);
+		return adj_mates_bf.row(2 * i);
+	}
+	
+	MateRange getAdjMates2Bf(size_t i) const {
+		assert(0 <= i && i < getNumOfI());
+		assert(!items_bf[i].isvertex);
+		return adj_mates_bf.row(2 * i + 1);
+	}
+	
+	MateRange getAdjMatesAf(size_t i) const {
+		assert(0 <= i && i < getNumOfI());
+		assert(items_af[i].isvertex);
+		return adj_mates_af.row(2 * i);
+	}
+	
+	MateRange getAdjMates1Af(size_t i) const {
+		assert(0 <= i && i < getNumOfI());
+		assert(!items_af[i].isvertex);
+		return adj_mates_af.row(2 * i);
+	}
+	
+	MateRange getAdjMates2Af(size_t i) const {
+		assert(0 <= i && i < getNumOfI());
+		assert(!items_af[i].isvertex);
+		return adj_mates_af.row(2 * i + 1);
+	}
+	
 	size_t getLevelBf(const Item& item) const {
-		return lev_of_item_bf.at(item);
+		if (item.isvertex) return getNumOfI() - pos_of_vertex_bf.at(item.v);
+		return getNumOfI() - pos_of_edge_bf.at(item.eid);
 	}
 	
 	size_t getLevelAf(const Item& item) const {
-		return lev_of_item_af.at(item);
+		if (item.isvertex) return getNumOfI() - pos_of_vertex_af.at(item.v);
+		return getNumOfI() - pos_of_edge_af.at(item.eid);
+	}
+	
+private:
+	// mate indices of the neighbors of v in the frontier
+	void addAdjRow(MateTable& table, int v,
+				   const Vec< bool >& in_frontier, Vec< int >& buf) const {
+		buf.clear();
+		for (size_t k = adj_head[v]; k < adj_head[v + 1]; ++k) {
+			int u = arcs[k].to;
+			if (u != v && in_frontier[u]) buf.push_back(u);
+		}
+		table.addRow(buf, mate_index);
 	}
 	
+	void pushVertexBf(int v, size_t i, const AddInfoHV& addinfo,
+					  const Vec< bool >& in_frontier, Vec< int >& buf) {
+		Item vi(v);
+		vi.i = i;
+		pos_of_vertex_bf[v] = items_bf.size();
+		items_bf.push_back(vi);
+		addinfo_bf.push_back(addinfo);
+		addAdjRow(adj_mates_bf, v, in_frontier, buf);
+		adj_mates_bf.addEmptyRow();
+	}
+	
+	void pushVertexAf(int v, size_t i, const AddInfoHV& addinfo,
+					  const Vec< bool >& in_frontier, Vec< int >& buf) {
+		Item vi(v);
+		vi.i = i;
+		pos_of_vertex_af[v] = items_af.size();
+		items_af.push_back(vi);
+		addinfo_af.push_back(addinfo);
+		addAdjRow(adj_mates_af, v, in_frontier, buf);
+		adj_mates_af.addEmptyRow();
+	}
+	
+public:
 	void setItems() {
 		assert(isOrdered());
 		
+		size_t num_of_V = getNumOfV();
+		size_t num_of_E = getNumOfE();
+		
 		items_bf.clear();
 		items_af.clear();
+		items_bf.reserve(num_of_V + num_of_E);
+		items_af.reserve(num_of_V + num_of_E);
 		
 		addinfo_bf.clear();
 		addinfo_af.clear();
+		addinfo_bf.reserve(num_of_V + num_of_E);
+		addinfo_af.reserve(num_of_V + num_of_E);
 		
-		lev_of_item_bf.clear();
-		lev_of_item_af.clear();
+		pos_of_vertex_bf.assign(num_of_V, 0);
+		pos_of_vertex_af.assign(num_of_V, 0);
+		pos_of_edge_bf.assign(num_of_E, 0);
+		pos_of_edge_af.assign(num_of_E, 0);
 		
-		std::vector< bool > vis(getNumOfV(), false);
+		adj_mates_bf.clear();
+		adj_mates_af.clear();
 		
-		USet< int > frontier;
-		size_t num_of_E = getNumOfE();
-		size_t lev_bf = getNumOfV() + getNumOfE();
-		size_t lev_af = lev_bf;
+		Vec< bool > vis(num_of_V, false);
+		Vec< bool > in_frontier(num_of_V, false);
+		Vec< int > buf;
+		int fsize = 0;
 		
 		for (size_t i = 0; i < num_of_E; ++i) {
-			Edge e = getEdge(i);
+			const Edge& e = getEdge(i);
 			vis[e.v1] = vis[e.v2] = true;
 			
 			// bf in
-			if (e.in1) {
-				Item v1i(e.v1);
-				v1i.i = e.i1;
-				AddInfoHV addinfo1;
-				addinfo1.frontier = frontier;
-								
-				auto it = frontier.begin(), eit = frontier.end();
-				for (; it != eit; ++it) if (isAdj(e.v1, *it)) {
-					addinfo1.adj.insert(*it);
-				}
-				
-				items_bf.push_back(v1i);
-				addinfo_bf.push_back(addinfo1);
-				
-				lev_of_item_bf[v1i] = lev_bf;
-				--lev_bf;
-			}
+			AddInfoHV addinfo_in;
+			addinfo_in.fsize = fsize;
 			
-			if (e.in2) {
-				Item v2i(e.v2);
-				v2i.i = e.i2;
-				AddInfoHV addinfo2;
-				addinfo2.frontier = frontier;
-								
-				auto it = frontier.begin(), eit = frontier.end();
-				for (; it != eit; ++it) if (isAdj(e.v2, *it)) {
-					addinfo2.adj.insert(*it);
-				}
-				
-				items_bf.push_back(v2i);
-				addinfo_bf.push_back(addinfo2);
-				
-				lev_of_item_bf[v2i] = lev_bf;
-				--lev_bf;
-			}
+			if (e.in1) pushVertexBf(e.v1, e.i1, addinfo_in, in_frontier, buf);
+			if (e.in2) pushVertexBf(e.v2, e.i2, addinfo_in, in_frontier, buf);
 			
-			frontier.insert(e.v1);
-			frontier.insert(e.v2);
+			if (!in_frontier[e.v1]) { in_frontier[e.v1] = true; ++fsize; }
+			if (!in_frontier[e.v2]) { in_frontier[e.v2] = true; ++fsize; }
 			
-			Item ei(e);
-			AddInfoHV addinfo(getAddInfo(i));
+			Item ei(e, i);
+			const AddInfoHV& addinfo = getAddInfo(i);
 			
 			// bf
+			pos_of_edge_bf[i] = items_bf.size();
 			items_bf.push_back(ei);
 			addinfo_bf.push_back(addinfo);
+			adj_mates_bf.addRow(getAdjMates1(i));
+			adj_mates_bf.addRow(getAdjMates2(i));
 			
-			lev_of_item_bf[ei] = lev_bf;
-			--lev_bf;
+			// af (the endpoints leave at the following vertex items)
+			AddInfoHV addinfo_e(addinfo);
+			addinfo_e.leave[0] = addinfo_e.leave[1] = -1;
 			
-			// af
+			pos_of_edge_af[i] = items_af.size();
 			items_af.push_back(ei);
-			addinfo_af.push_back(addinfo);
-			
-			lev_of_item_af[ei] = lev_af;
-			--lev_af;
+			addinfo_af.push_back(addinfo_e);
+			adj_mates_af.addRow(getAdjMates1(i));
+			adj_mates_af.addRow(getAdjMates2(i));
 			
 			// af out
 			if (e.out1) {
-				Item v1i(e.v1);
-				v1i.i = e.i1;
 				AddInfoHV addinfo1;
-				addinfo1.frontier = frontier;
+				addinfo1.addLeave(e.v1);
+				addinfo1.fsize = fsize;
 				
-				frontier.erase(e.v1);
+				in_frontier[e.v1] = false;
+				--fsize;
 				
-				auto it = frontier.begin(), eit = frontier.end();
-				for (; it != eit; ++it) if (isAdj(e.v1, *it)) {
-					addinfo1.adj.insert(*it);
-				}
-				
-				items_af.push_back(v1i);
-				addinfo_af.push_back(addinfo1);
-				
-				lev_of_item_af[v1i] = lev_af;
-				--lev_af;
+				pushVertexAf(e.v1, e.i1, addinfo1, in_frontier, buf);
 			}
 			
 			if (e.out2) {
-				Item v2i(e.v2);
-				v2i.i = e.i2;
 				AddInfoHV addinfo2;
-				addinfo2.frontier = frontier;
-				
-				frontier.erase(e.v2);
+				addinfo2.addLeave(e.v2);
+				addinfo2.fsize = fsize;
 				
-				auto it = frontier.begin(), eit = frontier.end();
-				for (; it != eit; ++it) if (isAdj(e.v2, *it)) {
-					addinfo2.adj.insert(*it);
-				}
+				in_frontier[e.v2] = false;
+				--fsize;
 				
-				items_af.push_back(v2i);
-				addinfo_af.push_back(addinfo2);
-				
-				lev_of_item_af[v2i] = lev_af;
-				--lev_af;
+				pushVertexAf(e.v2, e.i2, addinfo2, in_frontier, buf);
 			}
 		}
 		
-		for (size_t v = 0; v < getNumOfV(); ++v) {
+		for (size_t v = 0; v < num_of_V; ++v) {
 			if (!vis[v]) {
-				Item vi(v);
-				vi.i = 0;
-				
 				AddInfoHV addinfo;
-				addinfo.frontier = USet< int >();
-				
-				items_af.push_back(vi);
-				addinfo_af.push_back(addinfo);
-				
-				lev_of_item_af[vi] = lev_af;
-				--lev_af;
-				
-				items_bf.push_back(vi);
-				addinfo_bf.push_back(addinfo);
-				
-				lev_of_item_bf[vi] = lev_bf;
-				--lev_bf;
+				pushVertexAf(v, 0, addinfo, in_frontier, buf);
+				pushVertexBf(v, 0, addinfo, in_frontier, buf);
 			}
 		}
 		
-		assert(lev_af == 0);
-		assert(lev_bf == 0);
+		assert(items_af.size() == num_of_V + num_of_E);
+		assert(items_bf.size() == num_of_V + num_of_E);
 		set_end = true;
 	}
 };
@@ -0,0 +1,76 @@
+#ifndef MATE_TABLE_HPP
+#define MATE_TABLE_HPP
+
+#include <cassert>
+#include <algorithm>
+
+#include "commons.hpp"
+
+namespace hybriddd {
+
+// read-only run of mate indices
+class MateRange {
+private:
+	const size_t* first;
+	const size_t* last;
+
+public:
+	MateRange() : first(0), last(0) {}
+	MateRange(const size_t* first_, const size_t* last_) : first(first_), last(last_) {}
+
+	const size_t* begin() const { return first; }
+	const size_t* end() const { return last; }
+
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+};
+
+class GraphCache;
+
+// rows of mate indices packed into one flat array (CSR)
+class MateTable {
+	friend class GraphCache;
+
+private:
+	Vec< size_t > head;
+	Vec< size_t > body;
+
+public:
+	MateTable() : head(1, 0) {}
+
+	void clear() {
+		head.assign(1, 0);
+		body.clear();
+	}
+
+	// appends a row holding the mate index of every vertex in vs
+	template < class VSET >
+	void addRow(const VSET& vs, const Vec< size_t >& mate_index) {
+		size_t st = body.size();
+
+		auto it = vs.begin(), eit = vs.end();
+		for (; it != eit; ++it) body.push_back(mate_index[*it]);
+
+		std::sort(body.begin() + st, body.end());
+		head.push_back(body.size());
+	}
+
+	// appends a copy of a row of another table
+	void addRow(const MateRange& r) {
+		body.insert(body.end(), r.begin(), r.end());
+		head.push_back(body.size());
+	}
+
+	void addEmptyRow() { head.push_back(body.size()); }
+
+	size_t numOfRows() const { return head.size() - 1; }
+
+	MateRange row(size_t r) const {
+		assert(r < numOfRows());
+		return MateRange(body.data() + head[r], body.data() + head[r + 1]);
+	}
+};
+
+} // namespace hybriddd
+
+#endif // MATE_TABLE_HPP
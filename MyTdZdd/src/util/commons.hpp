@@ -32,6 +32,11 @@ void fopen_err(std::string fname) {
 	exit(1);
 }
 
+void format_err(std::string fname) {
+	std::cerr << "file format error [" << fname << "]\n";
+	exit(1);
+}
+
 bool isdouble(std::string s) {
 	for (size_t i = 1; i < s.size(); ++i) if (!isdigit(s[i]) && s[i] != '.') return false;
 	return true;
@@ -0,0 +1,166 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <iostream>
+#include <stdint.h>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <tdzdd/DdSpec.hpp>
+#include <tdzdd/DdStructure.hpp>
+
+/**
+ * Pseudo-random DD spec whose children depend only on the state, so that
+ * every builder makes the same diagram.
+ * A state is a key and a tag; states agreeing on the key are equivalent.
+ */
+template<typename S, int ARITY>
+class HashDdBase: public tdzdd::DdSpec<S,std::pair<uint64_t,int>,ARITY> {
+protected:
+    typedef std::pair<uint64_t,int> State;
+
+private:
+    int const n;
+    uint64_t const width;
+    uint64_t const seed;
+    int const tags;
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+public:
+    HashDdBase(int n, size_t width, uint64_t seed, int tags)
+            : n(n), width(width), seed(seed), tags(tags) {
+        assert(n >= 1);
+        assert(width >= 1);
+        assert(tags >= 1);
+    }
+
+    int getRoot(State& s) const {
+        s = State(0, 0);
+        return n;
+    }
+
+    int getChild(State& s, int level, int take) const {
+        uint64_t h = mix(mix(s.first ^ seed) + level * ARITY + take);
+        if (level <= 1) return (h & 1) ? -1 : 0;
+        if (h % 8 == 0) return 0;
+        s.first = (h >> 8) % width;
+        s.second = (h >> 40) % tags;
+        return level - 1;
+    }
+
+    size_t hashCode(State const& s) const {
+        return s.first * 314159257;
+    }
+
+    bool equalTo(State const& s1, State const& s2) const {
+        return s1.first == s2.first;
+    }
+
+    void printState(std::ostream& os, State const& s) const {
+        os << s.first << "/" << s.second;
+    }
+};
+
+/**
+ * HashDdBase without merging; every tag is 0.
+ */
+template<int ARITY>
+class HashDd: public HashDdBase<HashDd<ARITY>,ARITY> {
+public:
+    HashDd(int n, size_t width, uint64_t seed)
+            : HashDdBase<HashDd<ARITY>,ARITY>(n, width, seed, 1) {
+    }
+};
+
+/**
+ * HashDdBase where merge_states keeps the states with the smallest tag
+ * among equivalent ones, whatever order they come in.
+ */
+template<int ARITY>
+class MergingHashDd: public HashDdBase<MergingHashDd<ARITY>,ARITY> {
+    typedef typename HashDdBase<MergingHashDd<ARITY>,ARITY>::State State;
+
+public:
+    MergingHashDd(int n, size_t width, uint64_t seed)
+            : HashDdBase<MergingHashDd<ARITY>,ARITY>(n, width, seed, 3) {
+    }
+
+    int mergeStates(State& s1, State& s2) const {
+        if (s1.second < s2.second) return 2;
+        if (s1.second > s2.second) return 1;
+        return 0;
+    }
+};
+
+/**
+ * Builds SPEC<ARITY> for ten seeds with the serial DdBuilder and with
+ * @p build on the given number of threads, and checks that the diagrams
+ * are the same.
+ * Every MP level runs in parallel, however narrow (ParallelThreshold).
+ * @param build functor called as build(dd, spec) to construct dd.
+ */
+template<template<int> class SPEC, int ARITY, typename BUILD>
+void compareWithSerial(BUILD build, int threads, int n, int w) {
+#ifdef _OPENMP
+    int const saved = omp_get_max_threads();
+    omp_set_num_threads(threads);
+#endif
+    tdzdd::ParallelThreshold::set(0);
+
+    for (uint64_t seed = 1; seed <= 10; ++seed) {
+        SPEC<ARITY> spec(n, w, seed);
+        tdzdd::DdStructure<ARITY> s(spec, false);
+        tdzdd::DdStructure<ARITY> p;
+        build(p, spec);
+        if (!tdzdd::MayMergeStates<SPEC<ARITY> >::value) {
+            ASSERT_EQ(s.size(), p.size());
+        }
+
+        s.zddReduce();
+        p.zddReduce();
+        ASSERT_EQ(s.zddCardinality(), p.zddCardinality());
+        ASSERT_EQ(s, p);
+    }
+
+    tdzdd::ParallelThreshold::reset();
+#ifdef _OPENMP
+    omp_set_num_threads(saved);
+#endif
+}
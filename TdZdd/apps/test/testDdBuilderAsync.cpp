@@ -0,0 +1,72 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <tdzdd/DdStructure.hpp>
+
+#include "HashDd.hpp"
+
+using namespace tdzdd;
+
+/*
+ * Builds the spec with DdStructure::constructAsync.
+ * One thread falls back to the serial builder, and specs that merge states
+ * to DdBuilderMPC.
+ */
+struct BuildAsync {
+    template<typename SPEC, int ARITY>
+    void operator()(DdStructure<ARITY>& dd, SPEC const& spec) const {
+        dd.constructAsync(spec);
+    }
+};
+
+template<template<int> class SPEC, int A>
+void do_async_test(int threads, int n, int w) {
+    compareWithSerial<SPEC,A>(BuildAsync(), threads, n, w);
+}
+
+TEST(DdBuilderAsyncTest, MayMergeStates) {
+    ASSERT_FALSE(MayMergeStates<HashDd<2> >::value);
+    ASSERT_TRUE(MayMergeStates<MergingHashDd<2> >::value);
+}
+
+TEST(DdBuilderAsyncTest, Binary) {
+    do_async_test<HashDd,2>(2, 60, 1000);
+    do_async_test<HashDd,2>(4, 60, 1000);
+}
+
+TEST(DdBuilderAsyncTest, Ternary) {
+    do_async_test<HashDd,3>(2, 40, 300);
+    do_async_test<HashDd,3>(4, 40, 300);
+}
+
+TEST(DdBuilderAsyncTest, OneThread) {
+    do_async_test<HashDd,2>(1, 60, 1000);
+}
+
+TEST(DdBuilderAsyncTest, MergeStates) {
+    do_async_test<MergingHashDd,2>(1, 60, 1000);
+    do_async_test<MergingHashDd,2>(4, 60, 1000);
+}
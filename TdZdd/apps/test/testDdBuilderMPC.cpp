@@ -0,0 +1,62 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <tdzdd/DdStructure.hpp>
+
+#include "HashDd.hpp"
+
+using namespace tdzdd;
+
+/*
+ * Builds the spec with DdBuilderMPC.
+ */
+struct BuildMPC {
+    template<typename SPEC, int ARITY>
+    void operator()(DdStructure<ARITY>& dd, SPEC const& spec) const {
+        dd = DdStructure<ARITY>(spec, true);
+    }
+};
+
+template<template<int> class SPEC, int A>
+void do_mpc_test(int threads, int n, int w) {
+    compareWithSerial<SPEC,A>(BuildMPC(), threads, n, w);
+}
+
+TEST(DdBuilderMPCTest, Binary) {
+    do_mpc_test<HashDd,2>(2, 60, 1000);
+    do_mpc_test<HashDd,2>(4, 60, 1000);
+}
+
+TEST(DdBuilderMPCTest, Ternary) {
+    do_mpc_test<HashDd,3>(2, 40, 300);
+    do_mpc_test<HashDd,3>(4, 40, 300);
+}
+
+TEST(DdBuilderMPCTest, MergeStates) {
+    do_mpc_test<MergingHashDd,2>(2, 60, 1000);
+    do_mpc_test<MergingHashDd,2>(4, 60, 1000);
+    do_mpc_test<MergingHashDd,3>(4, 40, 300);
+}
@@ -0,0 +1,250 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+#include <tdzdd/DdStructure.hpp>
+
+using namespace tdzdd;
+
+extern bool useMP;
+
+/*
+ * Writes v to every element in turn and checks that it reads back,
+ * that the other elements stay 0, and that no spare bit is set.
+ */
+template<int BITS>
+void do_packed_test(int v) {
+    typedef PackedArray<BITS> Array;
+    typedef typename Array::Word Word;
+    int const n = 3 * Array::FIELDS + 1;
+    int const used = Array::FIELDS * BITS;
+    Word const spare = used < 64 ? ~Word(0) << used : 0;
+
+    std::vector<Word> buf(Array::words(n) + 1, 0);
+    ASSERT_EQ(4, Array::words(n));
+    Array a(buf.data());
+
+    for (int i = 0; i < n; ++i) {
+        a[i] = v;
+        for (int j = 0; j < n; ++j) {
+            ASSERT_EQ(j == i ? v : 0, int(a[j]));
+        }
+        for (size_t w = 0; w < buf.size(); ++w) {
+            ASSERT_EQ(Word(0), buf[w] & spare);
+        }
+        ASSERT_EQ(Word(0), buf.back());
+        a[i] = 0;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        a[i] = v;
+    }
+    for (int i = 0; i < n; ++i) {
+        ASSERT_EQ(v, int(a[i]));
+    }
+    for (size_t w = 0; w < buf.size(); ++w) {
+        ASSERT_EQ(Word(0), buf[w] & spare);
+    }
+}
+
+template<int BITS>
+void do_packed_test() {
+    int const lo = PackedArray<BITS>::MIN_VALUE;
+    int const hi = PackedArray<BITS>::MAX_VALUE;
+    ASSERT_EQ(-(1LL << (BITS - 1)), lo);
+    ASSERT_EQ((1LL << (BITS - 1)) - 1, hi);
+    do_packed_test<BITS>(lo);
+    do_packed_test<BITS>(hi);
+    do_packed_test<BITS>(-1);
+    do_packed_test<BITS>(1);
+}
+
+TEST(PackedArrayTest, Values) {
+    do_packed_test<2>();
+    do_packed_test<3>();
+    do_packed_test<6>();
+    do_packed_test<7>();
+    do_packed_test<16>();
+    do_packed_test<31>();
+}
+
+TEST(PackedArrayTest, Proxy) {
+    typedef PackedArray<6> Array;
+    size_t buf[2] = { 0, 0 };
+    Array a(buf);
+    int const last = Array::FIELDS - 1; // the last field of word 0
+    int const lo = Array::MIN_VALUE;
+    int const hi = Array::MAX_VALUE;
+
+    a[last] = hi - 1;
+    a[last + 1] = a[last];
+    ++a[last + 1];
+    ASSERT_EQ(hi, int(a[last + 1]));
+    a[last] = lo + 1;
+    --a[last];
+    ASSERT_EQ(lo, int(a[last]));
+    ASSERT_EQ(0, int(a[last - 1]));
+    ASSERT_EQ(0, int(a[last + 2]));
+}
+
+TEST(PackedArrayTest, ConstView) {
+    typedef PackedArray<6> Array;
+    size_t buf[2] = { 0, 0 };
+    Array a(buf);
+    int const last = Array::FIELDS - 1;
+    int const lo = Array::MIN_VALUE;
+
+    a[last] = lo;
+    a[last + 1] = 5;
+    size_t const* cbuf = buf;
+    PackedConstArray<6> c(cbuf);
+    PackedConstArray<6> d = a;
+    ASSERT_EQ(lo, c[last]);
+    ASSERT_EQ(5, c[last + 1]);
+    ASSERT_EQ(0, c[last + 2]);
+    ASSERT_EQ(lo, d[last]);
+    ASSERT_EQ(5, d[last + 1]);
+    ASSERT_TRUE((std::is_same<int,decltype(c[0])>::value));
+    ASSERT_TRUE((std::is_same<PackedConstArray<6>,
+            ArrayView<PackedBits<6> >::ConstArray>::value));
+}
+
+/*
+ * Item i is put into bin i % k when taken and taken out of bin (3 * i) % k
+ * when not, as long as every bin holds -cap to cap items.
+ */
+template<typename T>
+class BinArray: public PodArrayDdSpec<BinArray<T>,T,2> {
+    typedef typename PodArrayDdSpec<BinArray<T>,T,2>::Array Array;
+    typedef typename PodArrayDdSpec<BinArray<T>,T,2>::Ref Ref;
+
+    int const n;
+    int const k;
+    int const cap;
+
+public:
+    BinArray(int n, int k, int cap) :
+            n(n), k(k), cap(cap) {
+        this->setArraySize(k);
+    }
+
+    int getRoot(Array a) const {
+        for (int j = 0; j < k; ++j) {
+            a[j] = 0;
+        }
+        return n;
+    }
+
+    int getChild(Array a, int level, int take) const {
+        int const i = n - level;
+        Ref c = a[take ? i % k : (3 * i) % k];
+        if (take) {
+            if (c == cap) return 0;
+            ++c;
+        }
+        else {
+            if (c == -cap) return 0;
+            --c;
+        }
+        return (level == 1) ? -1 : level - 1;
+    }
+};
+
+/*
+ * BinArray that also counts the items taken and allows at most n / 2.
+ */
+template<typename T>
+class BinHybrid: public PodHybridDdSpec<BinHybrid<T>,int,T,2> {
+    typedef typename PodHybridDdSpec<BinHybrid<T>,int,T,2>::A_Array Array;
+    typedef typename PodHybridDdSpec<BinHybrid<T>,int,T,2>::A_Ref Ref;
+
+    int const n;
+    int const k;
+    int const cap;
+
+public:
+    BinHybrid(int n, int k, int cap) :
+            n(n), k(k), cap(cap) {
+        this->setArraySize(k);
+    }
+
+    int getRoot(int& count, Array a) const {
+        count = 0;
+        for (int j = 0; j < k; ++j) {
+            a[j] = 0;
+        }
+        return n;
+    }
+
+    int getChild(int& count, Array a, int level, int take) const {
+        int const i = n - level;
+        Ref c = a[take ? i % k : (3 * i) % k];
+        if (take) {
+            if (c == cap || ++count > n / 2) return 0;
+            ++c;
+        }
+        else {
+            if (c == -cap) return 0;
+            --c;
+        }
+        return (level == 1) ? -1 : level - 1;
+    }
+};
+
+/*
+ * Builds the spec with plain int8_t and with packed elements of BITS bits
+ * and checks that the diagrams, and the states they print, are the same.
+ */
+template<template<typename> class SPEC, int BITS>
+void do_spec_test(int n, int k, int cap) {
+    std::ostringstream pdot, qdot;
+    SPEC<int>(8, k, cap).dumpDot(pdot, ""); // unreduced, so a few levels
+    SPEC<PackedBits<BITS> >(8, k, cap).dumpDot(qdot, "");
+    ASSERT_EQ(pdot.str(), qdot.str());
+
+    DdStructure<2> p(SPEC<int8_t>(n, k, cap), useMP);
+    DdStructure<2> q(SPEC<PackedBits<BITS> >(n, k, cap), useMP);
+    ASSERT_EQ(p.size(), q.size());
+    p.zddReduce();
+    q.zddReduce();
+    ASSERT_NE(DdStructure<2>(0), p);
+    ASSERT_EQ(p.zddCardinality(), q.zddCardinality());
+    ASSERT_EQ(p, q);
+}
+
+TEST(PackedArrayTest, PodArrayDdSpec) {
+    do_spec_test<BinArray,3>(30, 5, 3); // -3 to 3 in one word
+    do_spec_test<BinArray,16>(30, 5, 3); // 4 fields per word
+}
+
+TEST(PackedArrayTest, PodHybridDdSpec) {
+    do_spec_test<BinHybrid,3>(30, 5, 3);
+    do_spec_test<BinHybrid,16>(30, 5, 3);
+}
@@ -0,0 +1,121 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <tdzdd/DdStructure.hpp>
+
+#include "HashDd.hpp"
+
+using namespace tdzdd;
+
+/*
+ * Builds, reduces and evaluates the spec with the MP algorithms on four
+ * threads and the given threshold, and compares the results with those
+ * of the serial algorithms.
+ * Levels of HashDd have up to w nodes, so a threshold below w mixes
+ * serial and parallel levels.
+ */
+template<int A>
+void do_threshold_test(size_t threshold, int n, int w) {
+#ifdef _OPENMP
+    int const saved = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    ParallelThreshold::set(threshold);
+
+    for (uint64_t seed = 1; seed <= 5; ++seed) {
+        HashDd<A> spec(n, w, seed);
+        DdStructure<A> s(spec, false);
+        DdStructure<A> p(spec, true);
+        ASSERT_EQ(s.size(), p.size());
+
+        DdStructure<A> sq = s;
+        DdStructure<A> pq = p;
+        sq.qddReduce(); // Algorithm-R, which makes a different QDD
+        pq.qddReduce();
+        ASSERT_EQ(sq.bddCardinality(n), pq.bddCardinality(n));
+
+        DdStructure<A> sb = s;
+        DdStructure<A> pb = p;
+        sb.bddReduce();
+        pb.bddReduce();
+        ASSERT_EQ(sb, pb);
+        ASSERT_EQ(sb.bddCardinality(n), pb.bddCardinality(n));
+
+        s.zddReduce();
+        p.zddReduce();
+        ASSERT_EQ(s, p);
+        ASSERT_EQ(s.zddCardinality(), p.zddCardinality());
+    }
+
+    ParallelThreshold::reset();
+#ifdef _OPENMP
+    omp_set_num_threads(saved);
+#endif
+}
+
+TEST(ParallelThresholdTest, AllParallel) {
+    do_threshold_test<2>(0, 60, 1000);
+    do_threshold_test<3>(0, 40, 300);
+}
+
+TEST(ParallelThresholdTest, Mixed) {
+    do_threshold_test<2>(30, 60, 1000);
+    do_threshold_test<2>(300, 60, 1000);
+    do_threshold_test<3>(30, 40, 300);
+}
+
+TEST(ParallelThresholdTest, AllSerial) {
+    do_threshold_test<2>(size_t(-1), 60, 1000);
+}
+
+#ifdef _OPENMP
+TEST(ParallelThresholdTest, CalibratedWithThreads) {
+    char const* env = std::getenv("TDZDD_MP_THRESHOLD");
+    if (env != 0 && *env != '\0') return; // given by the user
+
+    int const saved = omp_get_max_threads();
+    ParallelThreshold::reset();
+    omp_set_num_threads(1);
+    ASSERT_EQ(size_t(-1), ParallelThreshold::value());
+    ASSERT_FALSE(ParallelThreshold::wide(size_t(1) << 30));
+
+    omp_set_num_threads(2);
+    ASSERT_GT(size_t(-1), ParallelThreshold::value());
+    ASSERT_TRUE(ParallelThreshold::wide(size_t(1) << 30));
+
+    omp_set_num_threads(1);
+    ASSERT_TRUE(ParallelThreshold::wide(size_t(1) << 30)); // calibrated
+
+    ParallelThreshold::reset();
+    omp_set_num_threads(saved);
+}
+#endif
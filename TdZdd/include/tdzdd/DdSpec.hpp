@@ -32,6 +32,8 @@
 #include "dd/DepthFirstSearcher.hpp"
 #include "util/demangle.hpp"
 #include "util/MessageHandler.hpp"
+#include "util/PackedArray.hpp"
+#include "util/WordArray.hpp"
 
 namespace tdzdd {
 
@@ -342,15 +344,18 @@ public:
  * and cannot be changed.
  * If you want some arbitrary-sized data storage for states,
  * use pointers to those storages in DdSpec instead.
+ * With T = PackedBits<BITS>, the elements are signed integers of BITS bits
+ * packed in words, and the array is passed as PackedArray<BITS>
+ * (PackedConstArray<BITS> to printState).
  *
  * Every implementation must have the following functions:
- * - int getRoot(T* array)
- * - int getChild(T* array, int level, int value)
+ * - int getRoot(Array array)
+ * - int getChild(Array array, int level, int value)
  *
  * Optionally, the following functions can be overloaded:
- * - void mergeStates(T* array1, T* array2)
+ * - void mergeStates(Array array1, Array array2)
  * - void printLevel(std::ostream& os, int level) const
- * - void printState(std::ostream& os, State const* array) const
+ * - void printState(std::ostream& os, ConstArray array) const
  *
  * @tparam S the class implementing this class.
  * @tparam T data type of array elements.
@@ -358,8 +363,13 @@ public:
  */
 template<typename S, typename T, int AR>
 class PodArrayDdSpec: public DdSpecBase<S,AR> {
+    typedef ArrayView<T> View;
+
 public:
-    typedef T State;
+    typedef typename View::State State;
+    typedef typename View::Array Array;
+    typedef typename View::ConstArray ConstArray;
+    typedef typename View::Ref Ref;
 
 private:
     typedef size_t Word;
@@ -367,14 +377,6 @@ private:
     int arraySize;
     int dataWords;
 
-    static State* state(void* p) {
-        return static_cast<State*>(p);
-    }
-
-    static State const* state(void const* p) {
-        return static_cast<State const*>(p);
-    }
-
 protected:
     void setArraySize(int n) {
         assert(0 <= n);
@@ -382,7 +384,7 @@ protected:
             throw std::runtime_error(
                     "Cannot set array size twice; use setArraySize(int) only once in the constructor of DD spec.");
         arraySize = n;
-        dataWords = (n * sizeof(State) + sizeof(Word) - 1) / sizeof(Word);
+        dataWords = View::words(n);
     }
 
     int getArraySize() const {
@@ -402,12 +404,16 @@ public:
     }
 
     int get_root(void* p) {
-        return this->entity().getRoot(state(p));
+        Word* pa = static_cast<Word*>(p);
+        for (int i = 0; i < dataWords; ++i) {
+            pa[i] = 0; // spare bits are hashed and compared
+        }
+        return this->entity().getRoot(View::array(p));
     }
 
     int get_child(void* p, int level, int value) {
         assert(0 <= value && value < S::ARITY);
-        return this->entity().getChild(state(p), level, value);
+        return this->entity().getChild(View::array(p), level, value);
     }
 
     void get_copy(void* to, void const* from) {
@@ -419,12 +425,12 @@ public:
         }
     }
 
-    int mergeStates(T* a1, T* a2) {
+    int mergeStates(Array a1, Array a2) {
         return 0;
     }
 
     int merge_states(void* p1, void* p2) {
-        return this->entity().mergeStates(state(p1), state(p2));
+        return this->entity().mergeStates(View::array(p1), View::array(p2));
     }
 
     void destruct(void* p) {
@@ -434,59 +440,48 @@ public:
     }
 
     size_t hash_code(void const* p, int level) const {
-        Word const* pa = static_cast<Word const*>(p);
-        Word const* pz = pa + dataWords;
-        size_t h = 0;
-        while (pa != pz) {
-            h += *pa++;
-            h *= 314159257;
-        }
-        return h;
+        return WordArray::hash(static_cast<Word const*>(p), dataWords);
     }
 
     bool equal_to(void const* p, void const* q, int level) const {
-        Word const* pa = static_cast<Word const*>(p);
-        Word const* qa = static_cast<Word const*>(q);
-        Word const* pz = pa + dataWords;
-        while (pa != pz) {
-            if (*pa++ != *qa++) return false;
-        }
-        return true;
+        return WordArray::equal(static_cast<Word const*>(p),
+                static_cast<Word const*>(q), dataWords);
     }
 
-    void printState(std::ostream& os, State const* a) const {
+    void printState(std::ostream& os, ConstArray a) const {
         os << "[";
         for (int i = 0; i < arraySize; ++i) {
             if (i > 0) os << ",";
-            os << a[i];
+            os << State(a[i]);
         }
         os << "]";
     }
 
-    void printStateAtLevel(std::ostream& os, State const* a, int level) const {
+    void printStateAtLevel(std::ostream& os, ConstArray a, int level) const {
         this->entity().printState(os, a);
     }
 
     void print_state(std::ostream& os, void const* p, int level) const {
-        this->entity().printStateAtLevel(os, state(p), level);
+        this->entity().printStateAtLevel(os, View::array(p), level);
     }
 };
 
 /**
  * Abstract class of DD specifications using both scalar and POD array states.
+ * With TA = PackedBits<BITS>, the array is packed as in PodArrayDdSpec.
  *
  * Every implementation must have the following functions:
- * - int getRoot(TS& scalar, TA* array)
- * - int getChild(TS& scalar, TA* array, int level, int value)
+ * - int getRoot(TS& scalar, A_Array array)
+ * - int getChild(TS& scalar, A_Array array, int level, int value)
  *
  * Optionally, the following functions can be overloaded:
  * - void construct(void* p)
  * - void getCopy(void* p, TS const& state)
- * - void mergeStates(TS& s1, TA* a1, TS& s2, TA* a2)
+ * - void mergeStates(TS& s1, A_Array a1, TS& s2, A_Array a2)
  * - size_t hashCode(TS const& state) const
  * - bool equalTo(TS const& state1, TS const& state2) const
  * - void printLevel(std::ostream& os, int level) const
- * - void printState(std::ostream& os, TS const& s, TA const* a) const
+ * - void printState(std::ostream& os, TS const& s, A_ConstArray a) const
  *
  * @tparam S the class implementing this class.
  * @tparam TS data type of scalar.
@@ -495,9 +490,14 @@ public:
  */
 template<typename S, typename TS, typename TA, int AR>
 class HybridDdSpec: public DdSpecBase<S,AR> {
+    typedef ArrayView<TA> View;
+
 public:
     typedef TS S_State;
-    typedef TA A_State;
+    typedef typename View::State A_State;
+    typedef typename View::Array A_Array;
+    typedef typename View::ConstArray A_ConstArray;
+    typedef typename View::Ref A_Ref;
 
 private:
     typedef size_t Word;
@@ -515,21 +515,19 @@ private:
         return *static_cast<S_State const*>(p);
     }
 
-    static A_State* a_state(void* p) {
-        return reinterpret_cast<A_State*>(static_cast<Word*>(p) + S_WORDS);
+    static A_Array a_state(void* p) {
+        return View::array(static_cast<Word*>(p) + S_WORDS);
     }
 
-    static A_State const* a_state(void const* p) {
-        return reinterpret_cast<A_State const*>(static_cast<Word const*>(p)
-                + S_WORDS);
+    static A_ConstArray a_state(void const* p) {
+        return View::array(static_cast<Word const*>(p) + S_WORDS);
     }
 
 protected:
     void setArraySize(int n) {
         assert(0 <= n);
         arraySize = n;
-        dataWords = S_WORDS
-                + (n * sizeof(A_State) + sizeof(Word) - 1) / sizeof(Word);
+        dataWords = S_WORDS + View::words(n);
     }
 
     int getArraySize() const {
@@ -551,6 +549,10 @@ public:
 
     int get_root(void* p) {
         this->entity().construct(p);
+        Word* pa = static_cast<Word*>(p);
+        for (int i = S_WORDS; i < dataWords; ++i) {
+            pa[i] = 0; // spare bits are hashed and compared
+        }
         return this->entity().getRoot(s_state(p), a_state(p));
     }
 
@@ -575,7 +577,7 @@ public:
         }
     }
 
-    int mergeStates(S_State& s1, A_State* a1, S_State& s2, A_State* a2) {
+    int mergeStates(S_State& s1, A_Array a1, S_State& s2, A_Array a2) {
         return 0;
     }
 
@@ -600,15 +602,8 @@ public:
 
     size_t hash_code(void const* p, int level) const {
         size_t h = this->entity().hashCodeAtLevel(s_state(p), level);
-        h *= 271828171;
-        Word const* pa = static_cast<Word const*>(p);
-        Word const* pz = pa + dataWords;
-        pa += S_WORDS;
-        while (pa != pz) {
-            h += *pa++;
-            h *= 314159257;
-        }
-        return h;
+        return WordArray::hash(static_cast<Word const*>(p) + S_WORDS,
+                dataWords - S_WORDS, h * 271828171);
     }
 
     bool equalTo(S_State const& s1, S_State const& s2) const {
@@ -622,28 +617,20 @@ public:
     bool equal_to(void const* p, void const* q, int level) const {
         if (!this->entity().equalToAtLevel(s_state(p), s_state(q), level))
             return false;
-        Word const* pa = static_cast<Word const*>(p);
-        Word const* qa = static_cast<Word const*>(q);
-        Word const* pz = pa + dataWords;
-        pa += S_WORDS;
-        qa += S_WORDS;
-        while (pa != pz) {
-            if (*pa++ != *qa++) return false;
-        }
-        return true;
+        return WordArray::equal(static_cast<Word const*>(p) + S_WORDS,
+                static_cast<Word const*>(q) + S_WORDS, dataWords - S_WORDS);
     }
 
-    void printState(std::ostream& os, S_State const& s,
-            A_State const* a) const {
+    void printState(std::ostream& os, S_State const& s, A_ConstArray a) const {
         os << "[" << s << ":";
         for (int i = 0; i < arraySize; ++i) {
             if (i > 0) os << ",";
-            os << a[i];
+            os << A_State(a[i]);
         }
         os << "]";
     }
 
-    void printStateAtLevel(std::ostream& os, S_State const& s, A_State const* a,
+    void printStateAtLevel(std::ostream& os, S_State const& s, A_ConstArray a,
             int level) const {
         this->entity().printState(os, s, a);
     }
@@ -27,16 +27,20 @@
 #include <algorithm>
 #include <cassert>
 #include <climits>
+#include <functional>
 #include <ostream>
 #include <set>
 #include <map>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <random>
 
 #include "DdEval.hpp"
 #include "DdSpec.hpp"
 #include "dd/DdBuilder.hpp"
+#include "dd/CompactNodeTable.hpp"
 #include "dd/DdReducer.hpp"
 #include "dd/Node.hpp"
 #include "dd/NodeTable.hpp"
@@ -44,9 +48,11 @@
 #include "op/Lookahead.hpp"
 #include "op/Unreduction.hpp"
 #include "util/demangle.hpp"
+#include "util/MemoryPool.hpp"
 #include "util/MessageHandler.hpp"
 #include "util/MyHashTable.hpp"
 #include "util/MyVector.hpp"
+#include "util/ParallelThreshold.hpp"
 
 namespace tdzdd {
 
@@ -56,7 +62,8 @@ namespace tdzdd {
  */
 template<int ARITY>
 class DdStructure: public DdSpec<DdStructure<ARITY>,NodeId,ARITY> {
-    NodeTableHandler<ARITY> diagram; ///< The diagram structure.
+    mutable NodeTableHandler<ARITY> diagram; ///< The diagram structure.
+    mutable std::shared_ptr<CompactNodeTable<ARITY> const> compactDiagram; ///< The diagram in compact form, if any.
     NodeId root_;                    ///< Root node ID.
     bool useMP;                      ///< Flag to use MP algorithms.
 
@@ -108,8 +115,10 @@ public:
     DdStructure(DdSpecBase<SPEC,ARITY> const& spec, bool useMP = false) :
             useMP(useMP) {
 #ifdef _OPENMP
-        if (useMP) 
+        if (useMP) {
             constructMP_(spec.entity());
+            releaseFreeMemory();
+        }
         else
 #endif  
            construct_(spec.entity());
@@ -141,7 +150,7 @@ private:
     void constructMP_(SPEC const& spec) {
         MessageHandler mh;
         mh.begin(typenameof(spec));
-        DdBuilderMP<SPEC> zc(spec, diagram);
+        DdBuilderMPC<SPEC> zc(spec, diagram);
         int n = zc.initialize(root_);
 
         if (n > 0) {
@@ -161,13 +170,61 @@ private:
         mh.end(size());
     }
 
+    template<typename SPEC>
+    void constructAsync_(SPEC const& spec, std::true_type) {
+        constructMP_(spec); // merge_states needs the level barriers
+    }
+
+    template<typename SPEC>
+    void constructAsync_(SPEC const& spec, std::false_type) {
+        MessageHandler mh;
+        mh.begin(typenameof(spec));
+        DdBuilderAsync<SPEC> zc(spec, diagram);
+        int n = zc.initialize(root_);
+
+        if (n > 0) {
+#ifdef _OPENMP
+            mh << " " << omp_get_max_threads() << "x async";
+#endif
+            zc.construct();
+        }
+        else {
+            mh << " ...";
+        }
+
+        mh.end(size());
+    }
+
 public:
+    /**
+     * DD construction without level barriers (DdBuilderAsync).
+     * Every level is built by all threads at once, which pays off when most
+     * levels are narrow. Specs that may merge states (MayMergeStates) are
+     * built level by level (DdBuilderMPC) instead.
+     * Falls back to the serial builder when only one thread is available.
+     * @param spec DD spec.
+     */
+    template<typename SPEC>
+    void constructAsync(DdSpecBase<SPEC,ARITY> const& spec) {
+        useMP = true;
+#ifdef _OPENMP
+        if (omp_get_max_threads() >= 2) {
+            constructAsync_(spec.entity(),
+                    typename MayMergeStates<SPEC>::type());
+            releaseFreeMemory(); // before the caller goes on to reduction
+            return;
+        }
+#endif
+        construct_(spec.entity());
+    }
+
     /**
      * ZDD subsetting.
      * @param spec ZDD spec.
      */
     template<typename SPEC>
     void zddSubset(DdSpecBase<SPEC,ARITY> const& spec) {
+        expand();
 #ifdef _OPENMP
         if (useMP) zddSubsetMP_(spec.entity());
         else
@@ -262,25 +319,62 @@ public:
      * @return child node ID.
      */
     NodeId child(NodeId f, int b) const {
-        return diagram->child(f, b);
+        return compactDiagram ? compactDiagram->child(f, b) :
+                                diagram->child(f, b);
     }
 
     /**
      * Gets the diagram.
+     * A compact diagram is expanded first.
      * @return the node table handler.
      */
     NodeTableHandler<ARITY>& getDiagram() {
+        expand();
         return diagram;
     }
 
     /**
      * Gets the diagram.
+     * A compact diagram is expanded first.
      * @return the node table handler.
      */
     NodeTableHandler<ARITY> const& getDiagram() const {
+        expand();
         return diagram;
     }
 
+    /**
+     * Stores the diagram in CompactNodeTable, which takes half the memory
+     * for binary DDs. Evaluation, iteration and export work on it directly;
+     * the other operations expand it first.
+     * @return false if the diagram is too large to be compacted.
+     */
+    bool compact() {
+        if (compactDiagram) return true;
+        if (!CompactNodeTable<ARITY>::fits(*diagram)) return false;
+        compactDiagram.reset(new CompactNodeTable<ARITY>(diagram));
+        diagram = NodeTableHandler<ARITY>();
+        releaseFreeMemory();
+        return true;
+    }
+
+    /**
+     * Checks if the diagram is stored in compact form.
+     * @return true if the diagram is compact.
+     */
+    bool isCompact() const {
+        return bool(compactDiagram);
+    }
+
+    /**
+     * Restores the diagram from compact form.
+     */
+    void expand() const {
+        if (!compactDiagram) return;
+        compactDiagram->expand(diagram.init());
+        compactDiagram.reset();
+    }
+
     /**
      * Gets the level of the root node.
      * @return the level of root ZDD variable.
@@ -294,7 +388,7 @@ public:
      * @return the number of nonterminal nodes.
      */
     size_t size() const {
-        return diagram->size();
+        return compactDiagram ? compactDiagram->size() : diagram->size();
     }
 
     /**
@@ -313,8 +407,11 @@ public:
         int n = root_.row();
         if (n != o.root_.row()) return false;
         if (n == 0) return root_ == o.root_;
-        if (root_ == o.root_ && &*diagram == &*o.diagram) return true;
+        if (root_ == o.root_ && &*diagram == &*o.diagram
+                && compactDiagram == o.compactDiagram) return true;
         if (size() > o.size()) return o.operator==(*this);
+        expand();
+        o.expand();
 
         MyHashMap<InitializedNode<ARITY>,size_t> uniq;
         DataTable<NodeId> equiv(n + 1);
@@ -392,6 +489,7 @@ public:
      */
     template<bool BDD, bool ZDD>
     void reduce() {
+        expand();
         MessageHandler mh;
         mh.begin("reduction");
         int n = root_.row();
@@ -457,6 +555,14 @@ public:
      */
     template<typename S, typename T, typename R>
     R evaluate(DdEval<S,T,R> const& evaluator) const {
+        if (compactDiagram) return evaluate_(*compactDiagram, evaluator);
+        diagram->adviseSequential();
+        return evaluate_(*diagram, evaluator);
+    }
+
+private:
+    template<typename TABLE, typename S, typename T, typename R>
+    R evaluate_(TABLE const& table, DdEval<S,T,R> const& evaluator) const {
         S eval(evaluator.entity()); // copied
         bool msg = eval.showMessages();
         int n = root_.row();
@@ -484,9 +590,9 @@ public:
         }
 #endif
 
-        DataTable<T> work(diagram->numRows());
+        DataTable<T> work(table.numRows());
         {
-            size_t const m = (*diagram)[0].size();
+            size_t const m = table[0].size();
             assert(m >= 2);
             work[0].resize(m);
             for (size_t j = 0; j < m; ++j) {
@@ -495,12 +601,12 @@ public:
         }
 
         for (int i = 1; i <= n; ++i) {
-            MyVector<Node<ARITY> > const& node = (*diagram)[i];
+            auto const& node = table[i];
             size_t const m = node.size();
             work[i].resize(m);
 
 #ifdef _OPENMP
-            if (useMP)
+            if (useMP && ParallelThreshold::wide(m))
 #pragma omp parallel
             {
                 int k = omp_get_thread_num();
@@ -528,16 +634,13 @@ public:
                 eval.evalNode(work[i][j], i, values);
             }
 
-            MyVector<int> const& levels = diagram->lowerLevels(i);
+            MyVector<int> const& levels = table.lowerLevels(i);
             for (int const* t = levels.begin(); t != levels.end(); ++t) {
                 work[*t].clear();
                 eval.destructLevel(*t);
             }
 #ifdef _OPENMP
-            if (useMP)
-#pragma omp parallel
-            {
-                int k = omp_get_thread_num();
+            for (int k = 0; k < threads; ++k) {
                 for (int const* t = levels.begin(); t != levels.end(); ++t) {
                     evals[k].destructLevel(*t);
                 }
@@ -551,6 +654,16 @@ public:
         return retval;
     }
 
+    /**
+     * Gets a node.
+     * @param f node ID.
+     * @return node @p f.
+     */
+    Node<ARITY> node(NodeId f) const {
+        return compactDiagram ? compactDiagram->node(f) : diagram->node(f);
+    }
+
+public:
     /**
      * Iterator on a set of integer vectors represented by a DD.
      */
@@ -610,7 +723,7 @@ public:
 
             for (;;) {
                 while (f > 1) { /* down */
-                    Node<ARITY> const& s = (*dd.diagram)[f.row()][f.col()];
+                    Node<ARITY> const s = dd.node(f);
 
                     if (s.branch[0] != 0) {
                         cursor = path.size();
@@ -627,13 +740,12 @@ public:
 
                 for (; cursor >= 0; --cursor) { /* up */
                     Selection& sel = path[cursor];
-                    Node<ARITY> const& ss =
-                            (*dd.diagram)[sel.node.row()][sel.node.col()];
+                    Node<ARITY> const ss = dd.node(sel.node);
                     if (sel.val == false && ss.branch[1] != 0) {
                         f = sel.node;
                         sel.val = true;
                         path.resize(cursor + 1);
-                        f = dd.diagram->child(f, 1);
+                        f = dd.child(f, 1);
                         break;
                     }
                 }
@@ -703,7 +815,15 @@ public:
      * @param os the output stream.
      */
     void dumpSapporo(std::ostream& os) const {
-        int const n = diagram->numRows() - 1;
+        if (compactDiagram) return dumpSapporo_(*compactDiagram, os);
+        diagram->adviseSequential();
+        dumpSapporo_(*diagram, os);
+    }
+
+private:
+    template<typename TABLE>
+    void dumpSapporo_(TABLE const& table, std::ostream& os) const {
+        int const n = table.numRows() - 1;
         std::cout << "graph num of rows: " << n << "\n";
         size_t const l = size();
 
@@ -711,21 +831,21 @@ public:
         // os << "_o 1\n";
         // os << "_n " << l << "\n";
 
-        DataTable<size_t> nodeId(diagram->numRows());
+        DataTable<size_t> nodeId(table.numRows());
         size_t k = 0;
 
         for (int i = 1; i <= n; ++i) {
-            size_t const m = (*diagram)[i].size();
-            Node<ARITY> const* p = (*diagram)[i].data();
+            auto const& node = table[i];
+            size_t const m = node.size();
             nodeId[i].resize(m);
 
-            for (size_t j = 0; j < m; ++j, ++p) {
+            for (size_t j = 0; j < m; ++j) {
                 k += 2;
                 nodeId[i][j] = k;
                 os << k << " " << i;
 
                 for (int c = 0; c <= 1; ++c) {
-                    NodeId fc = p->branch[c];
+                    NodeId fc = node[j].branch[c];
                     if (fc == 0) {
                         os << " B";
                     }
@@ -740,7 +860,7 @@ public:
                 os << "\n";
             }
 
-            MyVector<int> const& levels = diagram->lowerLevels(i);
+            MyVector<int> const& levels = table.lowerLevels(i);
             for (int const* t = levels.begin(); t != levels.end(); ++t) {
                 nodeId[*t].clear();
             }
@@ -751,6 +871,8 @@ public:
         assert(k == l * 2);
     }
 
+public:
+
     /**
      * 从 ZDD 导出矩阵文件。
      * 每条从根节点到 T 节点的路径代表一个子集（连通子图的顶点集）。
@@ -759,7 +881,8 @@ public:
      * 其余行：<元素个数> [col ...]  (col 从 1 开始编号)
      */
     void dumpMatrix(std::ostream& os, uint64_t zddPath, int minPath = 5000, int maxPath = 100000) const {
-        int n = diagram->numRows() - 1;  // 顶点个数
+        int n = (compactDiagram ? compactDiagram->numRows() :
+                                  diagram->numRows()) - 1;  // 顶点个数
         std::vector<std::vector<int>> subsets;  // 保存所有连通子图的顶点集
         
         // 确定目标路径数
@@ -802,17 +925,17 @@ public:
             }
             
             int var = node.row();
-            Node<ARITY> const* p = &(*diagram)[var][node.col()];
+            Node<ARITY> const p = this->node(node);
             
             // Low 分支：不选当前顶点
-            dfs(p->branch[0], path);
+            dfs(p.branch[0], path);
             
             // 提前终止检查
             if (zddPath > maxPath && pathCount >= targetPath) return;
             
             // High 分支：选择当前顶点
             path.push_back(var);
-            dfs(p->branch[1], path);
+            dfs(p.branch[1], path);
             path.pop_back();
         };
         
@@ -878,14 +1001,14 @@ public:
             }
             
             int var = node.row();
-            Node<2> const* p = &(*diagram)[var][node.col()];
+            Node<2> const p = this->node(node);
             
-            dfs(p->branch[0], path);
+            dfs(p.branch[0], path);
             
             if (pathCount >= maxPathsPerCustomer) return;
             
             path.push_back(var);
-            dfs(p->branch[1], path);
+            dfs(p.branch[1], path);
             path.pop_back();
         };
         
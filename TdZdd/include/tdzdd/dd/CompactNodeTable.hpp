@@ -0,0 +1,246 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <stdint.h>
+
+#include "Node.hpp"
+#include "NodeTable.hpp"
+#include "../util/MyVector.hpp"
+
+namespace tdzdd {
+
+/**
+ * Read-only node table that stores a branch in 32 bits.
+ * A branch is kept as the global index of the child node, that is its
+ * column plus the number of nodes at the lower levels, with the attribute
+ * bit on top. The row is found again from a small table that maps blocks
+ * of global indices to rows. Binary nodes take 8 bytes instead of 16 bytes
+ * of NodeTableEntity, as long as there are less than 2^31 nodes in total.
+ */
+template<int ARITY>
+class CompactNodeTable {
+    static uint32_t const ATTR = uint32_t(1) << 31;
+    static int const BLOCKS_BITS = 12;
+
+    MyVector<size_t> offset_;   ///< Global index of the first node at each row.
+    MyVector<uint32_t> branch_; ///< Branches of the nonterminal nodes.
+    MyVector<int> blockRow;     ///< Row of the first node of each block.
+    int blockShift;             ///< Log2 of the block size.
+    MyVector<MyVector<int> > lowerLevelTable;
+
+    uint32_t encode(NodeId f) const {
+        uint32_t c = uint32_t(offset_[f.row()] + f.col());
+        return f.getAttr() ? c | ATTR : c;
+    }
+
+    NodeId decode(uint32_t c) const {
+        size_t const g = c & ~ATTR;
+        int i = blockRow[g >> blockShift];
+        while (offset_[i + 1] <= g) {
+            ++i;
+        }
+        return NodeId(i, g - offset_[i], (c & ATTR) != 0);
+    }
+
+    uint32_t const* branches(int i, size_t j) const {
+        return &branch_[(offset_[i] + j - offset_[1]) * ARITY];
+    }
+
+public:
+    /**
+     * Row of nodes, which are decoded on access.
+     */
+    class Row {
+        CompactNodeTable const& table;
+        int const i;
+
+    public:
+        Row(CompactNodeTable const& table, int i) :
+                table(table), i(i) {
+        }
+
+        size_t size() const {
+            return table.offset_[i + 1] - table.offset_[i];
+        }
+
+        Node<ARITY> operator[](size_t j) const {
+            return table.node(NodeId(i, j));
+        }
+    };
+
+    /**
+     * Checks if a node table can be compacted.
+     * @param table the node table.
+     * @return true if the table has less than 2^31 nodes.
+     */
+    static bool fits(NodeTableEntity<ARITY> const& table) {
+        return table.totalSize() < size_t(ATTR);
+    }
+
+    /**
+     * Constructor.
+     * Each level of the source diagram is released as soon as it is
+     * compacted, unless the diagram is shared.
+     * @param diagram the node table to be compacted, which must fit.
+     */
+    CompactNodeTable(NodeTableHandler<ARITY>& diagram) {
+        NodeTableEntity<ARITY> const& input = *diagram;
+        int const n = input.numRows() - 1;
+        assert(fits(input));
+
+        offset_.resize(n + 2);
+        offset_[0] = 0;
+        for (int i = 0; i <= n; ++i) {
+            offset_[i + 1] = offset_[i] + input[i].size();
+        }
+
+        size_t const total = offset_[n + 1];
+        blockShift = 0;
+        while ((total >> blockShift) >> BLOCKS_BITS) {
+            ++blockShift;
+        }
+        blockRow.resize((total >> blockShift) + 1);
+        for (int i = 0, k = 0; k < int(blockRow.size()); ++k) {
+            while (i < n && offset_[i + 1] <= (size_t(k) << blockShift)) {
+                ++i;
+            }
+            blockRow[k] = i;
+        }
+
+        lowerLevelTable.resize(n + 1);
+        for (int i = 1; i <= n; ++i) {
+            lowerLevelTable[i] = input.lowerLevels(i);
+        }
+
+        branch_.resize((offset_[n + 1] - offset_[1]) * ARITY);
+        for (int i = 1; i <= n; ++i) {
+            size_t const m = input[i].size();
+            if (m == 0) continue;
+            uint32_t* p = &branch_[(offset_[i] - offset_[1]) * ARITY];
+
+            for (size_t j = 0; j < m; ++j) {
+                for (int b = 0; b < ARITY; ++b) {
+                    *p++ = encode(input[i][j].branch[b]);
+                }
+            }
+
+            diagram.derefLevel(i);
+        }
+    }
+
+    /**
+     * Gets the number of rows.
+     * @return the number of rows.
+     */
+    int numRows() const {
+        return offset_.size() - 1;
+    }
+
+    /**
+     * Gets the number of nonterminal nodes.
+     * @return the number of nonterminal nodes.
+     */
+    size_t size() const {
+        return offset_[numRows()] - offset_[1];
+    }
+
+    /**
+     * Accesses to a row.
+     * @param i row index.
+     * @return the row.
+     */
+    Row operator[](int i) const {
+        return Row(*this, i);
+    }
+
+    /**
+     * Gets a node.
+     * @param f node ID.
+     * @return node @p f.
+     */
+    Node<ARITY> node(NodeId f) const {
+        if (f.row() == 0) return Node<ARITY>(f.col(), f.col());
+        uint32_t const* p = branches(f.row(), f.col());
+        Node<ARITY> node;
+        for (int b = 0; b < ARITY; ++b) {
+            node.branch[b] = decode(p[b]);
+        }
+        return node;
+    }
+
+    /**
+     * Gets a child node ID.
+     * @param f parent node ID.
+     * @param b child branch.
+     * @return the @p b-child of @p f.
+     */
+    NodeId child(NodeId f, int b) const {
+        return child(f.row(), f.col(), b);
+    }
+
+    /**
+     * Gets a child node ID.
+     * @param i parent row.
+     * @param j parent column.
+     * @param b child branch.
+     * @return the @p b-child of the parent.
+     */
+    NodeId child(int i, size_t j, int b) const {
+        assert(0 <= b && b < ARITY);
+        if (i == 0) return j;
+        return decode(branches(i, j)[b]);
+    }
+
+    /**
+     * Returns a collection of the lower levels that are referred
+     * by the given level and that are not referred directly by
+     * any higher levels.
+     * @param level the level.
+     */
+    MyVector<int> const& lowerLevels(int level) const {
+        return lowerLevelTable[level];
+    }
+
+    /**
+     * Restores the node table.
+     * @param table the node table to be overwritten.
+     */
+    void expand(NodeTableEntity<ARITY>& table) const {
+        int const n = numRows() - 1;
+        table.init(n + 1);
+
+        for (int i = 1; i <= n; ++i) {
+            size_t const m = (*this)[i].size();
+            table.initRow(i, m);
+            for (size_t j = 0; j < m; ++j) {
+                table[i][j] = node(NodeId(i, j));
+            }
+        }
+    }
+};
+
+} // namespace tdzdd
@@ -24,10 +24,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <condition_variable>
+#include <mutex>
 #include <ostream>
 #include <stdexcept>
+#include <type_traits>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -39,9 +44,12 @@
 #include "../DdSpec.hpp"
 #include "../util/MemoryPool.hpp"
 #include "../util/MessageHandler.hpp"
+#include "../util/MyConcurrentHashTable.hpp"
 #include "../util/MyHashTable.hpp"
 #include "../util/MyList.hpp"
+#include "../util/MyUniqueTable.hpp"
 #include "../util/MyVector.hpp"
+#include "../util/ParallelThreshold.hpp"
 
 namespace tdzdd {
 
@@ -174,7 +182,7 @@ protected:
 template<typename S>
 class DdBuilder: DdBuilderBase {
     typedef S Spec;
-    typedef MyHashTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
+    typedef MyUniqueTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
     static int const AR = Spec::ARITY;
 
     Spec spec;
@@ -266,12 +274,29 @@ public:
 
         {
             Hasher<Spec> hasher(spec, i);
-            UniqTable uniq(snodes.size() * 2, hasher, hasher);
+            UniqTable uniq(snodes.size(), hasher, hasher);
+
+            // hash codes of the next PD nodes, whose slots are prefetched
+            int const PD = UniqTable::PREFETCH_DISTANCE;
+            size_t codes[PD];
+            MyList<SpecNode>::iterator ahead = snodes.begin();
+            for (int k = 0; k < PD && ahead != snodes.end(); ++k, ++ahead) {
+                codes[k] = hasher(*ahead);
+                uniq.prefetch(codes[k]);
+            }
+            int k = 0;
 
             for (MyList<SpecNode>::iterator t = snodes.begin();
                     t != snodes.end(); ++t) {
                 SpecNode* p = *t;
-                SpecNode*& p0 = uniq.add(p);
+                size_t const h = codes[k];
+                if (ahead != snodes.end()) {
+                    codes[k] = hasher(*ahead);
+                    uniq.prefetch(codes[k]);
+                    ++ahead;
+                }
+                if (++k == PD) k = 0;
+                SpecNode*& p0 = uniq.add(p, h);
 
                 if (p0 == p) {
                     nodeId(p) = *srcPtr(p) = NodeId(i, m++);
@@ -394,7 +419,7 @@ public:
 template<typename S>
 class DdBuilderMP: DdBuilderMPBase {//TODO oneStorage
     typedef S Spec;
-    typedef MyHashTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
+    typedef MyUniqueTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
     static int const AR = Spec::ARITY;
     static int const TASKS_PER_THREAD = 10;
 
@@ -529,16 +554,34 @@ public:
                 }
                 if (m == 0) continue;
 
-                uniq.initialize(m * 2);
+                uniq.initialize(m);
                 size_t j = 0;
 
                 for (int y = 0; y < threads; ++y) {
                     MyList<SpecNode> &snodes = snodeTables[y][x][i];
 
+                    // see DdBuilder::construct
+                    int const PD = UniqTable::PREFETCH_DISTANCE;
+                    size_t codes[PD];
+                    MyList<SpecNode>::iterator ahead = snodes.begin();
+                    for (int k = 0; k < PD && ahead != snodes.end();
+                            ++k, ++ahead) {
+                        codes[k] = hasher(*ahead);
+                        uniq.prefetch(codes[k]);
+                    }
+                    int k = 0;
+
                     for (MyList<SpecNode>::iterator t = snodes.begin();
                             t != snodes.end(); ++t) {
                         SpecNode* p = *t;
-                        SpecNode*& p0 = uniq.add(p);
+                        size_t const h = codes[k];
+                        if (ahead != snodes.end()) {
+                            codes[k] = hasher(*ahead);
+                            uniq.prefetch(codes[k]);
+                            ++ahead;
+                        }
+                        if (++k == PD) k = 0;
+                        SpecNode*& p0 = uniq.add(p, h);
 
                         if (p0 == p) {
                             code(p) = ++j; // code(p) >= 1
@@ -664,6 +707,945 @@ public:
     }
 };
 
+/**
+ * Multi-threaded breadth-first DD builder with a concurrent unique table.
+ * The nodes of a level are deduplicated by all threads together in one
+ * open-addressing table with CAS insertion, instead of being shuffled into
+ * hash buckets that are deduplicated task by task as in DdBuilderMP.
+ * A duplicate is chained to the node that owns its slot without locking,
+ * and merged into it (merge_states) when the nodes are numbered.
+ * 1-terminal states are merged as in DdBuilder, first per thread and then
+ * across the threads at the end of each level.
+ * A level narrower than ParallelThreshold is built by the calling thread.
+ */
+template<typename S>
+class DdBuilderMPC: DdBuilderMPBase {
+    typedef S Spec;
+    typedef MyConcurrentHashTable<SpecNode*> UniqTable;
+    static int const AR = Spec::ARITY;
+    static int const CHUNKS_PER_THREAD = 10;
+
+    int const threads;
+    int const chunks;
+
+    MyVector<Spec> specs;
+    int const specNodeSize;
+    NodeTableEntity<AR>& output;
+    DdSweeper<AR> sweeper;
+
+    MyVector<MyVector<MyList<SpecNode> > > snodeTables; // [thread][level]
+    MyVector<SpecNode*> snodes;    // nodes of the current level
+    MyVector<size_t> chunkColumn;  // first column of each chunk of snodes
+    UniqTable uniq;
+
+    MyVector<MyVector<char> > oneStorages;        // [thread]
+    MyVector<MyVector<NodeBranchId> > oneSrcPtrs; // [thread]
+    MyVector<char> oneStorage;
+    void* const one;
+    MyVector<NodeBranchId> oneSrcPtr;
+
+    /* code(p) while a level is built:
+     * - owner of a table slot: (head of the chain of its duplicates) | 1
+     * - duplicate: next duplicate in the chain (0 at the end)
+     * - after numbering: -(column + 1) if p is to be expanded, >= 0 otherwise
+     */
+    static bool isOwner(SpecNode* p) {
+        return code(p) > 0 && (code(p) & 1);
+    }
+
+    static SpecNode* chainNext(SpecNode* p) {
+        return reinterpret_cast<SpecNode*>(code(p) & ~int64_t(1));
+    }
+
+    static void chain(SpecNode* p0, SpecNode* p) {
+        int64_t c = __atomic_load_n(&code(p0), __ATOMIC_RELAXED);
+        do {
+            code(p) = c & ~int64_t(1);
+        } while (!__atomic_compare_exchange_n(&code(p0), &c,
+                reinterpret_cast<int64_t>(p) | 1, true, __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED));
+    }
+
+    /*
+     * Merges the chain of p0 and numbers the surviving node.
+     * Nodes forwarded to the 0-terminal by merge_states are resolved here,
+     * like those in DdBuilder::construct.
+     */
+    void resolve(Spec& spec, SpecNode* p0, int i, size_t j) {
+        SpecNode* r = p0;
+
+        for (SpecNode* p = chainNext(p0); p != 0;) {
+            SpecNode* next = chainNext(p);
+
+            switch (spec.merge_states(state(r), state(p))) {
+            case 1:
+                for (SpecNode* q = p0; q != p; q = chainNext(q)) {
+                    *srcPtr(q) = 0;
+                }
+                spec.destruct(state(r));
+                r = p;
+                break;
+            case 2:
+                *srcPtr(p) = 0;
+                spec.destruct(state(p));
+                break;
+            default:
+                *srcPtr(p) = NodeId(i, j);
+                spec.destruct(state(p));
+                break;
+            }
+
+            p = next;
+        }
+
+        *srcPtr(r) = NodeId(i, j);
+        code(r) = -int64_t(j) - 1;
+    }
+
+    /*
+     * Takes a 1-terminal candidate s found by thread y in the current level,
+     * as DdBuilder::construct does with its single candidate.
+     * Each thread keeps its own candidate and only back-patches the branches
+     * of its own nodes; the candidates meet in mergeOnes().
+     */
+    NodeId takeOne(int y, void* s, NodeBranchId const& nbi) {
+        Spec& spec = specs[y];
+        void* const o = oneStorages[y].data();
+        MyVector<NodeBranchId>& srcs = oneSrcPtrs[y];
+
+        if (!srcs.empty()) {
+            switch (spec.merge_states(o, s)) {
+            case 1:
+                patchToZero(srcs);
+                spec.destruct(o);
+                break;
+            case 2:
+                return 0;
+            default:
+                srcs.push_back(nbi);
+                return 1;
+            }
+        }
+
+        spec.get_copy(o, s);
+        srcs.push_back(nbi);
+        return 1;
+    }
+
+    void patchToZero(MyVector<NodeBranchId>& srcs) {
+        for (size_t k = 0; k < srcs.size(); ++k) {
+            NodeBranchId const& nbi = srcs[k];
+            output[nbi.row][nbi.col].branch[nbi.val] = 0;
+        }
+        srcs.clear();
+    }
+
+    /*
+     * Merges the candidates of the threads into the one of the whole DD.
+     * Called by one thread after a level is built.
+     */
+    void mergeOnes() {
+        for (int y = 0; y < threads; ++y) {
+            MyVector<NodeBranchId>& srcs = oneSrcPtrs[y];
+            if (srcs.empty()) continue;
+            void* const o = oneStorages[y].data();
+            int r = 1;
+
+            if (!oneSrcPtr.empty()) {
+                r = specs[0].merge_states(one, o);
+                if (r == 1) {
+                    patchToZero(oneSrcPtr);
+                    specs[0].destruct(one);
+                }
+            }
+
+            if (r == 2) {
+                patchToZero(srcs);
+            }
+            else {
+                if (r == 1) specs[0].get_copy(one, o);
+                for (size_t k = 0; k < srcs.size(); ++k) {
+                    oneSrcPtr.push_back(srcs[k]);
+                }
+                srcs.clear();
+            }
+
+            specs[y].destruct(o);
+        }
+    }
+
+    void init(int n) {
+        for (int y = 0; y < threads; ++y) {
+            snodeTables[y].resize(n + 1);
+        }
+        if (n >= output.numRows()) output.setNumRows(n + 1);
+    }
+
+public:
+    DdBuilderMPC(Spec const& s, NodeTableHandler<AR>& output, int n = 0) :
+#ifdef _OPENMP
+            threads(omp_get_max_threads()),
+#else
+            threads(1),
+#endif
+            chunks(threads * CHUNKS_PER_THREAD),
+            specs(threads, s),
+            specNodeSize(getSpecNodeSize(s.datasize())),
+            output(output.privateEntity()),
+            sweeper(this->output, oneSrcPtr),
+            snodeTables(threads),
+            chunkColumn(chunks),
+            oneStorages(threads, MyVector<char>(s.datasize())),
+            oneSrcPtrs(threads),
+            oneStorage(s.datasize()),
+            one(oneStorage.data()) {
+        if (n >= 1) init(n);
+    }
+
+    ~DdBuilderMPC() {
+        if (!oneSrcPtr.empty()) {
+            specs[0].destruct(one);
+            oneSrcPtr.clear();
+        }
+    }
+
+    /**
+     * Schedules a top-down event.
+     * @param fp result storage.
+     * @param level node level of the event.
+     * @param s node state of the event.
+     */
+    void schedule(NodeId* fp, int level, void* s) {
+        SpecNode* p0 = snodeTables[0][level].alloc_front(specNodeSize);
+        specs[0].get_copy(state(p0), s);
+        srcPtr(p0) = fp;
+    }
+
+    /**
+     * Initializes the builder.
+     * @param root result storage.
+     */
+    int initialize(NodeId& root) {
+        sweeper.setRoot(root);
+        MyVector<char> tmp(specs[0].datasize());
+        void* const tmpState = tmp.data();
+        int n = specs[0].get_root(tmpState);
+
+        if (n <= 0) {
+            root = n ? 1 : 0;
+            n = 0;
+        }
+        else {
+            init(n);
+            schedule(&root, n, tmpState);
+        }
+
+        specs[0].destruct(tmpState);
+        if (!oneSrcPtr.empty()) {
+            specs[0].destruct(one);
+            oneSrcPtr.clear();
+        }
+        return n;
+    }
+
+    /**
+     * Builds one level.
+     * @param i level.
+     */
+    void construct(int i) {
+        assert(0 < i && i < output.numRows());
+        assert(output.numRows() - snodeTables[0].size() == 0);
+
+        MyVector<size_t> listStart(threads);
+        size_t n = 0;
+        for (int y = 0; y < threads; ++y) {
+            listStart[y] = n;
+            n += snodeTables[y][i].size();
+        }
+
+        int lowestChild = i - 1;
+        size_t deadCount = 0;
+
+        if (n == 0) {
+            output.initRow(i, output[i].size());
+            for (int y = 0; y < threads; ++y) {
+                specs[y].destructLevel(i);
+            }
+            sweeper.update(i, lowestChild, deadCount);
+            return;
+        }
+
+        snodes.resize(n);
+        uniq.resize(n);
+        size_t const chunkSize = (n + chunks - 1) / chunks;
+        bool const wide = ParallelThreshold::wide(n);
+
+#ifdef _OPENMP
+#pragma omp parallel if(wide) reduction(min:lowestChild) reduction(+:deadCount)
+#endif
+        {
+#ifdef _OPENMP
+            int yy = omp_get_thread_num();
+#else
+            int yy = 0;
+#endif
+
+            Spec& spec = specs[yy];
+            MyVector<char> tmp(spec.datasize());
+            void* const tmpState = tmp.data();
+            Hasher<Spec> hasher(spec, i);
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int y = 0; y < threads; ++y) {
+                size_t k = listStart[y];
+                MyList<SpecNode>& list = snodeTables[y][i];
+                for (MyList<SpecNode>::iterator t = list.begin();
+                        t != list.end(); ++t) {
+                    snodes[k++] = *t;
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int x = 0; x < chunks; ++x) {
+                size_t const m = uniq.tableSize();
+                uniq.clear(m * x / chunks, m * (x + 1) / chunks);
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1024)
+#endif
+            for (size_t k = 0; k < n; ++k) {
+                SpecNode* p = snodes[k];
+                code(p) = 1; // empty chain
+                bool inserted;
+                SpecNode* p0 = uniq.add(p, hasher, inserted);
+                if (!inserted) chain(p0, p);
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int x = 0; x < chunks; ++x) {
+                size_t m = 0;
+                size_t const kk = std::min(n, (x + 1) * chunkSize);
+                for (size_t k = x * chunkSize; k < kk; ++k) {
+                    if (isOwner(snodes[k])) ++m;
+                }
+                chunkColumn[x] = m;
+            }
+
+#ifdef _OPENMP
+#pragma omp single
+#endif
+            {
+                size_t m = output[i].size();
+                for (int x = 0; x < chunks; ++x) {
+                    size_t j = chunkColumn[x];
+                    chunkColumn[x] = m;
+                    m += j;
+                }
+
+                output.initRow(i, m);
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+            for (int x = 0; x < chunks; ++x) {
+                size_t j = chunkColumn[x];
+                size_t const kk = std::min(n, (x + 1) * chunkSize);
+                for (size_t k = x * chunkSize; k < kk; ++k) {
+                    SpecNode* p = snodes[k];
+                    if (isOwner(p)) resolve(spec, p, i, j++);
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 256)
+#endif
+            for (size_t k = 0; k < n; ++k) {
+                SpecNode* p = snodes[k];
+                if (code(p) >= 0) continue; // merged or forwarded
+
+                Node<AR>& q = output[i][-code(p) - 1];
+                bool allZero = true;
+                void* s = tmpState;
+
+                for (int b = 0; b < AR; ++b) {
+                    if (b < AR - 1) {
+                        spec.get_copy(s, state(p));
+                    }
+                    else {
+                        s = state(p);
+                    }
+
+                    int ii = spec.get_child(s, i, b);
+
+                    if (ii == 0) {
+                        q.branch[b] = 0;
+                    }
+                    else if (ii < 0) {
+                        q.branch[b] = takeOne(yy, s,
+                                NodeBranchId(i, -code(p) - 1, b));
+                        allZero = false;
+                    }
+                    else {
+                        assert(ii <= i - 1);
+                        SpecNode* pp = snodeTables[yy][ii].alloc_front(
+                                specNodeSize);
+                        spec.get_copy(state(pp), s);
+                        srcPtr(pp) = &q.branch[b];
+                        if (ii < lowestChild) lowestChild = ii;
+                        allZero = false;
+                    }
+
+                    spec.destruct(s);
+                }
+
+                if (allZero) ++deadCount;
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int y = 0; y < threads; ++y) {
+                snodeTables[y][i].clear();
+            }
+
+            spec.destructLevel(i);
+        }
+
+        if (!wide) { // only specs[0] has seen the level
+            for (int y = 1; y < threads; ++y) {
+                specs[y].destructLevel(i);
+            }
+        }
+
+        mergeOnes();
+        sweeper.update(i, lowestChild, deadCount);
+    }
+};
+
+/**
+ * Tells whether spec S may merge states.
+ * It is false only if S inherits merge_states(void*, void*) and
+ * mergeStates from the same class of DdSpec.hpp, which never merges.
+ * Specs that forward merge_states to another spec count as merging.
+ */
+template<typename S>
+class MayMergeStates {
+    template<typename C, typename F>
+    static C* owner(F C::*);
+
+    template<typename T>
+    static std::integral_constant<bool,
+            std::is_same<decltype(owner(&T::merge_states)),T*>::value
+                    || !std::is_same<decltype(owner(&T::merge_states)),
+                            decltype(owner(&T::mergeStates))>::value> test(int);
+
+    template<typename T>
+    static std::true_type test(...);
+
+public:
+    typedef decltype(test<S>(0)) type;
+    static bool const value = type::value;
+};
+
+template<typename S>
+bool const MayMergeStates<S>::value;
+
+/**
+ * Multi-threaded DD builder without level barriers.
+ * A node is expanded as soon as it is found, by work-stealing threads that
+ * prefer higher levels, and its children go straight into the unique table
+ * of their level (sharded, one lock per shard).
+ * A level is finalized (copied into the output and swept) as soon as all
+ * the levels above it are finalized and its own nodes are expanded.
+ * merge_states(void*, void*) is never called, because a node may already
+ * be expanded when an equivalent one arrives; specs that may merge states
+ * are rejected at compile time (MayMergeStates).
+ * Workers without work sleep until a node is pushed or the build ends.
+ */
+template<typename S>
+class DdBuilderAsync {
+    static_assert(!MayMergeStates<S>::value,
+            "DdBuilderAsync cannot build specs that merge states");
+
+    typedef S Spec;
+    static int const AR = Spec::ARITY;
+    static int const SHARDS_PER_THREAD = 16;
+    static size_t const STEAL_MAX = 256;
+
+    /* SpecNode
+     * ┌────────┬────────┬─────────┬─────┬────────┬─────
+     * │ srcPtr │  code  │branch[0]│ ... │state[0]│ ...
+     * └────────┴────────┴─────────┴─────┴────────┴─────
+     * code: column of the node, or -1 for a duplicate.
+     * branch: the output node, copied into the table when the level is done.
+     */
+    union SpecNode {
+        NodeId* srcPtr;
+        int64_t code;
+    };
+
+    static int const nodeOffset = 2;
+    static int const headerSize = nodeOffset
+            + (sizeof(Node<AR>) + sizeof(SpecNode) - 1) / sizeof(SpecNode);
+
+    static NodeId*& srcPtr(SpecNode* p) {
+        return p[0].srcPtr;
+    }
+
+    static int64_t& code(SpecNode* p) {
+        return p[1].code;
+    }
+
+    static Node<AR>& node(SpecNode* p) {
+        return *reinterpret_cast<Node<AR>*>(p + nodeOffset);
+    }
+
+    static void* state(SpecNode* p) {
+        return p + headerSize;
+    }
+
+    static void const* state(SpecNode const* p) {
+        return p + headerSize;
+    }
+
+    static int getSpecNodeSize(int n) {
+        if (n < 0)
+            throw std::runtime_error("storage size is not initialized!!!");
+        return headerSize + (n + sizeof(SpecNode) - 1) / sizeof(SpecNode);
+    }
+
+    // table entry; probes compare the hash codes before the states
+    struct Entry {
+        size_t hash;
+        SpecNode* ptr;
+
+        Entry() :
+                hash(0), ptr(0) {
+        }
+
+        Entry(size_t hash, SpecNode* ptr) :
+                hash(hash), ptr(ptr) {
+        }
+
+        bool operator==(Entry const& o) const {
+            return ptr == o.ptr;
+        }
+    };
+
+    struct Hasher {
+        Spec const* spec;
+        int level;
+
+        Hasher(Spec const& spec, int level) :
+                spec(&spec), level(level) {
+        }
+
+        size_t operator()(Entry const& e) const {
+            return e.hash;
+        }
+
+        bool operator()(Entry const& e, Entry const& f) const {
+            return e.hash == f.hash
+                    && spec->equal_to(state(e.ptr), state(f.ptr), level);
+        }
+    };
+
+    typedef MyHashTable<Entry,Hasher,Hasher> UniqTable;
+
+    struct Shard {
+        std::mutex lock;
+        UniqTable uniq;
+
+        Shard(Hasher const& h) :
+                uniq(h, h) {
+        }
+    };
+
+    struct Level {
+        std::atomic<Shard*> shards;   // allocated by the first insertion
+        std::atomic<size_t> count;    // nodes found, i.e. the next column
+        std::atomic<size_t> expanded; // nodes expanded
+        std::atomic<size_t> dead;     // nodes whose branches are all 0
+        std::atomic<int> lowest;      // lowest child level
+    };
+
+    struct Worker {
+        std::mutex lock;
+        MyVector<MyVector<SpecNode*> > work; // nodes to expand by level
+        int top;                             // no work above this level
+        int done;                            // lowest level destructed
+    };
+
+    int const threads;
+    int const shards;
+
+    MyVector<Spec> specs;
+    int const specNodeSize;
+    NodeTableEntity<AR>& output;
+    DdSweeper<AR> sweeper;
+
+    MyVector<MyVector<MyList<SpecNode> > > snodeTables; // [thread][level]
+    int n;
+    Level* levels;
+    Worker* workers;
+
+    std::mutex finalizeLock;
+    std::atomic<int> top; // the highest level that is not finalized
+
+    std::mutex idleLock;
+    std::condition_variable wakeUp;
+    std::atomic<int> idle; // workers about to sleep or sleeping
+    size_t epoch;          // bumped under idleLock to wake them
+
+    void init(int n) {
+        this->n = n;
+        for (int y = 0; y < threads; ++y) {
+            snodeTables[y].resize(n + 1);
+            workers[y].work.resize(n + 1);
+            workers[y].top = 0;
+            workers[y].done = n + 1;
+        }
+        levels = new Level[n + 1];
+        for (int i = 0; i <= n; ++i) {
+            levels[i].shards = 0;
+            levels[i].count = 0;
+            levels[i].expanded = 0;
+            levels[i].dead = 0;
+            levels[i].lowest = i - 1;
+        }
+        top = n;
+        if (n >= output.numRows()) output.setNumRows(n + 1);
+    }
+
+    Shard* getShards(int i) {
+        Shard* s = levels[i].shards.load();
+        if (s != 0) return s;
+
+        Hasher h(specs[0], i);
+        Shard* t = static_cast<Shard*>(::operator new(shards * sizeof(Shard)));
+        for (int k = 0; k < shards; ++k) {
+            new (t + k) Shard(h);
+        }
+        if (levels[i].shards.compare_exchange_strong(s, t)) return t;
+
+        deleteShards(t);
+        return s;
+    }
+
+    void deleteShards(Shard* t) {
+        for (int k = 0; k < shards; ++k) {
+            t[k].~Shard();
+        }
+        ::operator delete(t);
+    }
+
+    void push(int y, int i, SpecNode* p) {
+        Worker& w = workers[y];
+        {
+            std::lock_guard<std::mutex> g(w.lock);
+            w.work[i].push_back(p);
+            if (w.top < i) w.top = i;
+        }
+        if (idle > 0) {
+            std::lock_guard<std::mutex> g(idleLock);
+            ++epoch;
+            wakeUp.notify_one();
+        }
+    }
+
+    /*
+     * Sleeps until another worker pushes a node or the build ends,
+     * unless there is something to steal.
+     * A push either sees idle > 0 and bumps epoch, or comes before the
+     * steal below.
+     */
+    void sleep(int y) {
+        ++idle;
+        size_t e;
+        {
+            std::lock_guard<std::mutex> g(idleLock);
+            e = epoch;
+        }
+        if (top > 0 && !steal(y)) {
+            std::unique_lock<std::mutex> g(idleLock);
+            while (epoch == e && top > 0) {
+                wakeUp.wait(g);
+            }
+        }
+        --idle;
+    }
+
+    // takes a node of the highest level; i is set to the level
+    SpecNode* pop(int y, int& i) {
+        Worker& w = workers[y];
+        std::lock_guard<std::mutex> g(w.lock);
+        while (w.top > 0 && w.work[w.top].empty()) {
+            --w.top;
+        }
+        if (w.top == 0) return 0;
+
+        i = w.top;
+        SpecNode* p = w.work[i].back();
+        w.work[i].pop_back();
+        return p;
+    }
+
+    // moves up to half of the top level of another worker's work to y
+    bool steal(int y) {
+        MyVector<SpecNode*> loot;
+        int i = 0;
+
+        for (int d = 1; d < threads && loot.empty(); ++d) {
+            Worker& v = workers[(y + d) % threads];
+            std::lock_guard<std::mutex> g(v.lock);
+            while (v.top > 0 && v.work[v.top].empty()) {
+                --v.top;
+            }
+            if (v.top == 0) continue;
+
+            i = v.top;
+            MyVector<SpecNode*>& src = v.work[i];
+            size_t m = std::min(size_t(STEAL_MAX), (src.size() + 1) / 2);
+            for (size_t k = 0; k < m; ++k) {
+                loot.push_back(src.back());
+                src.pop_back();
+            }
+        }
+
+        if (loot.empty()) return false;
+
+        Worker& w = workers[y];
+        std::lock_guard<std::mutex> g(w.lock);
+        for (size_t k = 0; k < loot.size(); ++k) {
+            w.work[i].push_back(loot[k]);
+        }
+        if (w.top < i) w.top = i;
+        return true;
+    }
+
+    /*
+     * Finds or registers the node of p at level i.
+     * The column is known right away, so *srcPtr(p) is final on return.
+     * Returns false if p is a duplicate, which is no longer needed.
+     */
+    bool insert(int y, int i, SpecNode* p) {
+        Spec& spec = specs[y];
+        size_t h = spec.hash_code(state(p), i);
+
+        Shard& s = getShards(i)[h % shards];
+        SpecNode* p0;
+        {
+            std::lock_guard<std::mutex> g(s.lock);
+            p0 = s.uniq.add(Entry(h, p)).ptr;
+            if (p0 == p) code(p) = levels[i].count++;
+        }
+
+        if (p0 == p) {
+            *srcPtr(p) = NodeId(i, code(p));
+            push(y, i, p);
+            return true;
+        }
+
+        *srcPtr(p) = NodeId(i, code(p0));
+        code(p) = -1;
+        spec.destruct(state(p));
+        return false;
+    }
+
+    void expand(int y, int i, SpecNode* p, void* tmpState) {
+        Spec& spec = specs[y];
+        Node<AR>& q = node(p);
+        int lowestChild = i - 1;
+        bool allZero = true;
+        void* const s = tmpState;
+
+        for (int b = 0; b < AR; ++b) {
+            spec.get_copy(s, state(p)); // p stays in the table until finalize
+            int ii = spec.get_child(s, i, b);
+
+            if (ii <= 0) {
+                q.branch[b] = ii ? 1 : 0;
+                if (ii) allZero = false;
+            }
+            else {
+                assert(ii <= i - 1);
+                SpecNode* pp = snodeTables[y][ii].alloc_front(specNodeSize);
+                spec.get_copy(state(pp), s);
+                srcPtr(pp) = &q.branch[b];
+                // levels stay in memory until finalized; drop duplicates now
+                if (!insert(y, ii, pp)) snodeTables[y][ii].pop_front();
+                if (ii < lowestChild) lowestChild = ii;
+                allZero = false;
+            }
+
+            spec.destruct(s);
+        }
+
+        Level& lv = levels[i];
+        if (allZero) ++lv.dead;
+        int l = lv.lowest.load();
+        while (lowestChild < l && !lv.lowest.compare_exchange_weak(l, lowestChild)) {
+        }
+
+        if (++lv.expanded == lv.count && i == top) finalizeReady(true);
+    }
+
+    void finalize(int i) {
+        Level& lv = levels[i];
+        size_t m = lv.count;
+        output.initRow(i, m);
+
+        for (int y = 0; y < threads; ++y) {
+            MyList<SpecNode>& snodes = snodeTables[y][i];
+            for (typename MyList<SpecNode>::iterator t = snodes.begin();
+                    t != snodes.end(); ++t) {
+                SpecNode* p = *t;
+                if (code(p) < 0) continue;
+                output[i][code(p)] = node(p);
+                specs[0].destruct(state(p));
+            }
+            snodes.clear();
+        }
+
+        if (lv.shards != 0) deleteShards(lv.shards);
+        lv.shards = 0;
+        sweeper.update(i, lv.lowest, lv.dead);
+    }
+
+    /*
+     * Finalizes the levels from the top while they are complete.
+     * @param wait false to give up when another thread is finalizing.
+     */
+    void finalizeReady(bool wait) {
+        std::unique_lock<std::mutex> g(finalizeLock, std::defer_lock);
+        if (wait) g.lock();
+        else if (!g.try_lock()) return;
+
+        int t = top;
+        while (t > 0 && levels[t].expanded == levels[t].count) {
+            finalize(t);
+            top = --t;
+        }
+
+        if (t == 0) {
+            std::lock_guard<std::mutex> g(idleLock);
+            wakeUp.notify_all();
+        }
+    }
+
+    // calls destructLevel of worker y's spec for the finalized levels
+    void destructLevels(int y) {
+        int const t = top;
+        int& done = workers[y].done;
+        while (done > t + 1) {
+            specs[y].destructLevel(--done);
+        }
+    }
+
+    // expands nodes until every level is finalized
+    void run(int y) {
+        MyVector<char> tmp(specs[y].datasize());
+        void* const tmpState = tmp.data();
+
+        while (top > 0) {
+            int i;
+            SpecNode* p = pop(y, i);
+            if (p != 0) {
+                expand(y, i, p, tmpState);
+            }
+            else if (!steal(y)) {
+                finalizeReady(false);
+                sleep(y);
+            }
+            destructLevels(y);
+        }
+    }
+
+public:
+    DdBuilderAsync(Spec const& s, NodeTableHandler<AR>& output) :
+#ifdef _OPENMP
+            threads(omp_get_max_threads()),
+#else
+            threads(1),
+#endif
+            shards(threads * SHARDS_PER_THREAD),
+            specs(threads, s),
+            specNodeSize(getSpecNodeSize(s.datasize())),
+            output(output.privateEntity()),
+            sweeper(this->output),
+            snodeTables(threads),
+            n(0),
+            levels(0),
+            workers(new Worker[threads]),
+            top(0),
+            idle(0),
+            epoch(0) {
+    }
+
+    ~DdBuilderAsync() {
+        if (levels != 0) {
+            for (int i = 0; i <= n; ++i) {
+                if (levels[i].shards != 0) deleteShards(levels[i].shards);
+            }
+            delete[] levels;
+        }
+        delete[] workers;
+    }
+
+    /**
+     * Initializes the builder.
+     * @param root result storage.
+     * @return the number of levels.
+     */
+    int initialize(NodeId& root) {
+        sweeper.setRoot(root);
+        MyVector<char> tmp(specs[0].datasize());
+        void* const tmpState = tmp.data();
+        int n = specs[0].get_root(tmpState);
+
+        if (n <= 0) {
+            root = n ? 1 : 0;
+            n = 0;
+        }
+        else {
+            init(n);
+            SpecNode* p = snodeTables[0][n].alloc_front(specNodeSize);
+            specs[0].get_copy(state(p), tmpState);
+            srcPtr(p) = &root;
+            insert(0, n, p);
+        }
+
+        specs[0].destruct(tmpState);
+        return n;
+    }
+
+    /**
+     * Builds all the levels.
+     */
+    void construct() {
+        if (n <= 0) return;
+
+#ifdef _OPENMP
+#pragma omp parallel
+        run(omp_get_thread_num());
+#else
+        run(0);
+#endif
+
+        for (int y = 0; y < threads; ++y) {
+            destructLevels(y); // also for workers that did not run
+        }
+    }
+};
+
 /**
  * Breadth-first ZDD subset builder.
  */
@@ -671,7 +1653,7 @@ template<typename S>
 class ZddSubsetter: DdBuilderBase {
 //typedef typename std::remove_const<typename std::remove_reference<S>::type>::type Spec;
     typedef S Spec;
-    typedef MyHashTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
+    typedef MyUniqueTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
     static int const AR = Spec::ARITY;
 
     Spec spec;
@@ -782,7 +1764,7 @@ public:
             size_t n = list.size();
 
             if (n >= 2) {
-                UniqTable uniq(n * 2, hasher, hasher);
+                UniqTable uniq(n, hasher, hasher);
 
                 for (MyListOnPool<SpecNode>::iterator t = list.begin();
                         t != list.end(); ++t) {
@@ -950,7 +1932,7 @@ template<typename S>
 class ZddSubsetterMP: DdBuilderMPBase {//TODO oneStorage
 //typedef typename std::remove_const<typename std::remove_reference<S>::type>::type Spec;
     typedef S Spec;
-    typedef MyHashTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
+    typedef MyUniqueTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
     static int const AR = Spec::ARITY;
 
     int const threads;
@@ -1067,7 +2049,7 @@ public:
                     MyListOnPool<SpecNode> &snodes = snodeTables[y][i][j];
                     mm += snodes.size();
                 }
-                uniq.initialize(mm * 2);
+                uniq.initialize(mm);
                 size_t jj = 0;
 
                 for (int y = 0; y < threads; ++y) {
@@ -1275,7 +2257,7 @@ class DdDumper {
         }
     };
 
-    typedef MyHashTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
+    typedef MyUniqueTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
 
     static int getSpecNodeSize(int n) {
         if (n < 0)
@@ -37,7 +37,9 @@
 #include "NodeTable.hpp"
 #include "../util/MyHashTable.hpp"
 #include "../util/MyList.hpp"
+#include "../util/MyUniqueTable.hpp"
 #include "../util/MyVector.hpp"
+#include "../util/ParallelThreshold.hpp"
 
 namespace tdzdd {
 
@@ -202,12 +204,20 @@ public:
 
     /**
      * Reduces one level.
+     * With @p useMP, a level narrower than ParallelThreshold is reduced
+     * serially by reduce_(int), which unlike Algorithm-R can be mixed with
+     * reduceMP_(int) level by level.
      * @param i level.
      * @param useMP use an algorithm for multiple processors.
      */
     void reduce(int i, bool useMP = false) {
         if (useMP) {
-            reduceMP_(i);
+            if (ParallelThreshold::wide(input[i].size())) {
+                reduceMP_(i);
+            }
+            else {
+                reduce_(i);
+            }
         }
         else if (ARITY == 2) {
             algorithmR(i);
@@ -343,7 +353,7 @@ private:
         {
             //MyList<ReducNodeInfo> rni;
             //MyHashTable<ReducNodeInfo const*> uniq(m * 2);
-            MyHashTable<Node<ARITY> const*> uniq(m * 2);
+            MyUniqueTable<Node<ARITY> const*> uniq(m);
 
             for (size_t j = 0; j < m; ++j) {
                 Node<ARITY>* const p0 = input[i].data();
@@ -419,7 +429,8 @@ private:
 #pragma omp parallel
         {
             int y = omp_get_thread_num();
-            MyHashTable<ReducNodeInfo const*> uniq;
+            typedef MyUniqueTable<ReducNodeInfo const*> UniqTable;
+            UniqTable uniq;
 
 #pragma omp for schedule(static)
             for (size_t j = 0; j < m; ++j) {
@@ -475,16 +486,35 @@ private:
                     continue;
                 }
 
-                uniq.initialize(mm * 2);
+                uniq.initialize(mm);
                 size_t j = 0;
 
                 for (int yy = 0; yy < threads; ++yy) {
                     MyList<ReducNodeInfo>& taskq = taskMatrix[yy][x];
 
+                    // hash codes of the next PD nodes, whose slots are prefetched
+                    int const PD = UniqTable::PREFETCH_DISTANCE;
+                    size_t codes[PD];
+                    typename MyList<ReducNodeInfo>::iterator ahead =
+                            taskq.begin();
+                    for (int k = 0; k < PD && ahead != taskq.end();
+                            ++k, ++ahead) {
+                        codes[k] = (*ahead)->hash();
+                        uniq.prefetch(codes[k]);
+                    }
+                    int k = 0;
+
                     for (typename MyList<ReducNodeInfo>::iterator t =
                             taskq.begin(); t != taskq.end(); ++t) {
                         ReducNodeInfo const* p = *t;
-                        ReducNodeInfo const* pp = uniq.add(p);
+                        size_t const h = codes[k];
+                        if (ahead != taskq.end()) {
+                            codes[k] = (*ahead)->hash();
+                            uniq.prefetch(codes[k]);
+                            ++ahead;
+                        }
+                        if (++k == PD) k = 0;
+                        ReducNodeInfo const* pp = uniq.add(p, h);
 
                         if (pp == p) {
                             newIdTable[i][p->column] =
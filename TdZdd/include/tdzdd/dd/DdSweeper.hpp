@@ -29,6 +29,7 @@
 
 #include "Node.hpp"
 #include "NodeTable.hpp"
+#include "../util/MappedStorage.hpp"
 #include "../util/MessageHandler.hpp"
 #include "../util/MyVector.hpp"
 
@@ -38,6 +39,9 @@ namespace tdzdd {
  * On-the-fly DD cleaner.
  * Removes the nodes that are identified as equivalent to the 0-terminal
  * while top-down DD construction.
+ * It also pages out the rows whose edges are all completed, when the rows
+ * are in MappedStorage, so that only the frontier of the construction
+ * stays in memory.
  */
 template<int ARITY>
 class DdSweeper {
@@ -48,6 +52,7 @@ class DdSweeper {
 
     MyVector<int> sweepLevel;
     MyVector<size_t> deadCount;
+    MyVector<int> childLevel; ///< Lowest child level of each row, or -1 if completed.
     size_t allCount;
     size_t maxCount;
     NodeId* rootPtr;
@@ -92,6 +97,7 @@ public:
     void update(int current, int child, size_t count) {
         assert(1 <= current);
         assert(0 <= child);
+        if (MappedStorage::enabled()) pageOut(current, child);
         if (current <= 1) return;
 
         if (size_t(current) >= sweepLevel.size()) {
@@ -163,8 +169,36 @@ public:
         *rootPtr = newId[rootPtr->row()][rootPtr->col()];
         deadCount[k] = 0;
         allCount = diagram.size();
+
+        if (MappedStorage::enabled()) {
+            for (int i = k; i < int(childLevel.size()); ++i) {
+                if (childLevel[i] < 0) MappedStorage::pageOut(diagram[i].data());
+            }
+        }
         mh.end(diagram.size());
     }
+
+private:
+    /*
+     * Pages out the rows above the current level that have no edges
+     * to the levels not constructed yet.
+     */
+    void pageOut(int current, int child) {
+        if (childLevel.empty()) {
+            childLevel.resize(diagram.numRows());
+            for (int i = 0; i < int(childLevel.size()); ++i) {
+                childLevel[i] = 0;
+            }
+        }
+        childLevel[current] = child;
+
+        for (int i = current + 1; i < int(childLevel.size()); ++i) {
+            if (childLevel[i] >= current) {
+                MappedStorage::pageOut(diagram[i].data());
+                childLevel[i] = -1;
+            }
+        }
+    }
 };
 
 } // namespace tdzdd
@@ -28,6 +28,9 @@
 #include <stdint.h>
 #include <ostream>
 
+#include "../util/MappedStorage.hpp"
+#include "../util/MyVector.hpp"
+
 namespace tdzdd {
 
 int const NODE_ROW_BITS = 20;
@@ -207,4 +210,18 @@ struct InitializedNode: Node<ARITY> {
     }
 };
 
+/**
+ * Node rows go to memory-mapped files when MappedStorage is enabled.
+ */
+template<int ARITY>
+struct MyVectorAllocator<Node<ARITY> > : MappedAllocator<Node<ARITY> > {
+};
+
+/**
+ * So do rows of node IDs, such as the new IDs in DdReducer.
+ */
+template<>
+struct MyVectorAllocator<NodeId> : MappedAllocator<NodeId> {
+};
+
 } // namespace tdzdd
@@ -32,6 +32,7 @@
 
 #include "Node.hpp"
 #include "DataTable.hpp"
+#include "../util/MappedStorage.hpp"
 #include "../util/MyVector.hpp"
 
 namespace tdzdd {
@@ -236,6 +237,16 @@ public:
         return f;
     }
 
+    /**
+     * Hints that the rows will be read in order, bottom-up or top-down,
+     * if they are in MappedStorage.
+     */
+    void adviseSequential() const {
+        for (int i = 1; i < this->numRows(); ++i) {
+            MappedStorage::adviseSequential((*this)[i].data());
+        }
+    }
+
     /**
      * Deletes current index information.
      */
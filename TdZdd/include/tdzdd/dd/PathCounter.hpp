@@ -36,8 +36,9 @@
 #include "../util/MemoryPool.hpp"
 #include "../util/MyHashTable.hpp"
 #include "../util/MyList.hpp"
+#include "../util/MyUniqueTable.hpp"
 #include "../util/MyVector.hpp"
-#include "DdSpec.hpp"
+#include "../DdSpec.hpp"
 
 namespace tdzdd {
 
@@ -64,7 +65,7 @@ class PathCounter {
         }
     };
 
-    typedef MyHashTable<Word*,Hasher,Hasher> UniqTable;
+    typedef MyUniqueTable<Word*,Hasher,Hasher> UniqTable;
 
     Spec& spec;
     int const stateWords;
@@ -0,0 +1,228 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define TDZDD_MAPPED_BLOCKS
+#endif
+
+namespace tdzdd {
+
+/**
+ * Source of the memory blocks of MemoryPool and MyList.
+ * Block sizes grow geometrically from a small initial size, so that short
+ * lists stay small while long ones are made of a few large blocks.
+ * Blocks of at least MAP_THRESHOLD bytes are mapped directly instead of
+ * taken from the heap: they go back to the system as soon as they are
+ * freed, they may be backed by transparent huge pages, and each page is
+ * placed on the NUMA node of the thread that first writes it. The builders
+ * fill their per-thread lists and pools on the owner threads, so the
+ * default first-touch policy keeps them local without a NUMA library.
+ */
+class BlockAllocator {
+    struct Config {
+        size_t maxBytes;
+        bool hugePages;
+    };
+
+    /*
+     * Freed blocks are kept per thread, up to SPARE_BYTES for all threads
+     * together, so that the lists of the next level reuse pages that are
+     * already faulted in, and a list that pops and pushes across a block
+     * boundary does not map and unmap every time.
+     */
+    struct Spares {
+        static int const MAX_BLOCKS = 16;
+        void* block[MAX_BLOCKS];
+        size_t bytes[MAX_BLOCKS];
+        int count;
+        size_t total;
+
+        ~Spares() {
+            clear();
+        }
+
+        void clear() {
+            while (count > 0) {
+                --count;
+                unmap(block[count], bytes[count]);
+            }
+            spareTotal() -= total;
+            total = 0;
+        }
+    };
+
+    // bytes kept in the spares of all threads
+    static std::atomic<size_t>& spareTotal() {
+        static std::atomic<size_t> t(0);
+        return t;
+    }
+
+    static Config& config() {
+        static Config c = {size_t(4) << 20, false};
+        return c;
+    }
+
+    static Spares& spares() {
+        static thread_local Spares s = {{}, {}, 0, 0};
+        return s;
+    }
+
+    static size_t mappedBytes(size_t bytes) {
+        size_t const unit = (bytes >= HUGE_PAGE_SIZE) ? HUGE_PAGE_SIZE : 4096;
+        return (bytes + unit - 1) / unit * unit;
+    }
+
+    static void* map(size_t bytes) {
+#ifdef TDZDD_MAPPED_BLOCKS
+        size_t const len = mappedBytes(bytes);
+        bool const huge = config().hugePages && len >= HUGE_PAGE_SIZE;
+        size_t const extra = huge ? HUGE_PAGE_SIZE : 0;
+        void* p = mmap(0, len + extra, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        if (!huge) return p;
+
+        // trims the mapping to a huge page boundary
+        char* const q = static_cast<char*>(p);
+        size_t const head = (HUGE_PAGE_SIZE
+                - reinterpret_cast<size_t>(q) % HUGE_PAGE_SIZE)
+                % HUGE_PAGE_SIZE;
+        if (head != 0) munmap(q, head);
+        if (extra - head != 0) munmap(q + head + len, extra - head);
+#ifdef MADV_HUGEPAGE
+        madvise(q + head, len, MADV_HUGEPAGE);
+#endif
+        return q + head;
+#else
+        return ::operator new(bytes);
+#endif
+    }
+
+    static void unmap(void* p, size_t bytes) {
+#ifdef TDZDD_MAPPED_BLOCKS
+        munmap(p, mappedBytes(bytes));
+#else
+        ::operator delete(p);
+#endif
+    }
+
+public:
+    /// Blocks smaller than this stay on the heap.
+    static size_t const MAP_THRESHOLD = size_t(256) << 10;
+
+    /// Freed blocks kept for reuse by all threads together.
+    static size_t const SPARE_BYTES = size_t(32) << 20;
+
+    /// Size of a transparent huge page.
+    static size_t const HUGE_PAGE_SIZE = size_t(2) << 20;
+
+    /**
+     * Sets up the block sizes and huge pages.
+     * It should be called before building diagrams.
+     * @param maxBytes the size at which blocks stop growing.
+     * @param hugePages whether to ask for huge pages for large blocks.
+     */
+    static void configure(size_t maxBytes, bool hugePages) {
+        config().maxBytes = maxBytes;
+        config().hugePages = hugePages;
+    }
+
+    /**
+     * Gets the size of the block that follows a block.
+     * @param bytes the size of the current block.
+     * @return twice @p bytes, but not more than the configured maximum
+     *         unless @p bytes is already larger.
+     */
+    static size_t grow(size_t bytes) {
+        return std::max(bytes, std::min(bytes * 2, config().maxBytes));
+    }
+
+    /**
+     * Allocates a block.
+     * Large blocks are zero-filled pages that are not touched yet, unless
+     * they are reused from the blocks freed by the same thread.
+     * @param bytes the size of the block.
+     * @return the address of the block.
+     */
+    static void* allocate(size_t bytes) {
+        if (bytes < MAP_THRESHOLD) return ::operator new(bytes);
+        Spares& s = spares();
+        size_t const len = mappedBytes(bytes);
+        for (int k = s.count - 1; k >= 0; --k) {
+            if (mappedBytes(s.bytes[k]) != len) continue;
+            void* p = s.block[k];
+            s.total -= len;
+            spareTotal() -= len;
+            --s.count;
+            s.block[k] = s.block[s.count];
+            s.bytes[k] = s.bytes[s.count];
+            return p;
+        }
+        return map(bytes);
+    }
+
+    /**
+     * Deallocates a block.
+     * @param p the address given by allocate(size_t).
+     * @param bytes the size given to allocate(size_t).
+     */
+    static void deallocate(void* p, size_t bytes) {
+        if (bytes < MAP_THRESHOLD) {
+            ::operator delete(p);
+            return;
+        }
+        Spares& s = spares();
+        size_t const len = mappedBytes(bytes);
+        if (s.count < Spares::MAX_BLOCKS) {
+            if (spareTotal().fetch_add(len) + len <= SPARE_BYTES) {
+                s.block[s.count] = p;
+                s.bytes[s.count] = bytes;
+                ++s.count;
+                s.total += len;
+                return;
+            }
+            spareTotal() -= len;
+        }
+        unmap(p, bytes);
+    }
+
+    /**
+     * Returns the blocks kept for reuse by the calling thread to the system.
+     */
+    static void releaseSpares() {
+        spares().clear();
+    }
+};
+
+} // namespace tdzdd
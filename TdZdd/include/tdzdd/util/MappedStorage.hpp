@@ -0,0 +1,210 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define TDZDD_MAPPED_STORAGE
+#endif
+
+namespace tdzdd {
+
+/**
+ * Storage of large arrays in memory-mapped files.
+ * When a scratch directory is set, every array of at least THRESHOLD bytes
+ * allocated by MappedAllocator lives in its own file there, so that the
+ * kernel writes it out instead of running out of memory. The files are
+ * unlinked as soon as they are mapped, and vanish with the process.
+ */
+class MappedStorage {
+    struct Registry {
+        std::mutex lock;
+        std::map<void*,size_t> blocks; ///< Mapped address -> size.
+        std::string directory;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    static size_t lookup(void const* p) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.lock);
+        std::map<void*,size_t>::const_iterator t =
+                r.blocks.find(const_cast<void*>(p));
+        return t != r.blocks.end() ? t->second : 0;
+    }
+
+    static void fail(std::string const& what) {
+        throw std::runtime_error(
+                "MappedStorage: " + what + ": " + std::strerror(errno));
+    }
+
+public:
+    /// Arrays smaller than this stay on the heap.
+    static size_t const THRESHOLD = size_t(1) << 20;
+
+    /**
+     * Sets the scratch directory.
+     * Arrays allocated before keep their storage.
+     * @param dir the directory, or an empty string to stop using files.
+     */
+    static void setDirectory(std::string const& dir) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.lock);
+#ifdef TDZDD_MAPPED_STORAGE
+        r.directory = dir;
+#endif
+    }
+
+    /**
+     * Checks if a scratch directory is set.
+     * @return true if large arrays go to files.
+     */
+    static bool enabled() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.lock);
+        return !r.directory.empty();
+    }
+
+    /**
+     * Checks if an array of a given size goes to a file.
+     * @param bytes the size of the array.
+     * @return true if it should be mapped.
+     */
+    static bool wanted(size_t bytes) {
+        return bytes >= THRESHOLD && enabled();
+    }
+
+    /**
+     * Maps a new file of a given size.
+     * @param bytes the size.
+     * @return the address of the zero-filled memory.
+     */
+    static void* map(size_t bytes) {
+#ifdef TDZDD_MAPPED_STORAGE
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.lock);
+        std::string path = r.directory + "/tdzdd-XXXXXX";
+        int fd = mkstemp(&path[0]);
+        if (fd < 0) fail(path);
+        unlink(path.c_str());
+        if (ftruncate(fd, bytes) != 0) {
+            close(fd);
+            fail(path);
+        }
+        void* p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) fail(path);
+        r.blocks[p] = bytes;
+        return p;
+#else
+        throw std::runtime_error("MappedStorage: not supported");
+#endif
+    }
+
+    /**
+     * Unmaps memory if it is mapped by map(size_t).
+     * @param p the address.
+     * @return true if @p p was mapped.
+     */
+    static bool unmap(void* p) {
+#ifdef TDZDD_MAPPED_STORAGE
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.lock);
+        std::map<void*,size_t>::iterator t = r.blocks.find(p);
+        if (t == r.blocks.end()) return false;
+        munmap(p, t->second);
+        r.blocks.erase(t);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Hints that mapped memory will be read in order.
+     * Does nothing for other memory.
+     * @param p the address given by map(size_t).
+     */
+    static void adviseSequential(void const* p) {
+#ifdef TDZDD_MAPPED_STORAGE
+        size_t bytes = lookup(p);
+        if (bytes != 0) madvise(const_cast<void*>(p), bytes, MADV_SEQUENTIAL);
+#endif
+    }
+
+    /**
+     * Lets the kernel write mapped memory out to its file and drop it.
+     * It can still be accessed, at the cost of reading it back.
+     * Does nothing for other memory.
+     * @param p the address given by map(size_t).
+     */
+    static void pageOut(void const* p) {
+#ifdef TDZDD_MAPPED_STORAGE
+        size_t bytes = lookup(p);
+        if (bytes == 0) return;
+        void* q = const_cast<void*>(p);
+        msync(q, bytes, MS_ASYNC);
+#ifdef MADV_PAGEOUT
+        madvise(q, bytes, MADV_PAGEOUT);
+#else
+        madvise(q, bytes, MADV_DONTNEED);
+#endif
+#endif
+    }
+};
+
+/**
+ * Allocator that puts large arrays in MappedStorage when it is enabled.
+ * @tparam T element type.
+ */
+template<typename T>
+struct MappedAllocator {
+    T* allocate(size_t n) {
+        if (MappedStorage::wanted(n * sizeof(T))) {
+            return static_cast<T*>(MappedStorage::map(n * sizeof(T)));
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (MappedStorage::unmap(p)) return;
+        std::allocator<T>().deallocate(p, n);
+    }
+};
+
+} // namespace tdzdd
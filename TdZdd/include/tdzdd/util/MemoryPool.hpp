@@ -27,34 +27,70 @@
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
+#include "BlockAllocator.hpp"
 #include "MyVector.hpp"
 
 namespace tdzdd {
 
+/**
+ * Returns free heap memory and the spare blocks of all threads
+ * to the system.
+ * Memory freed by worker threads stays in their own malloc arenas and
+ * spares, where the thread that goes on cannot reuse it; call this after
+ * a parallel phase that has released a lot of memory.
+ */
+inline void releaseFreeMemory() {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    BlockAllocator::releaseSpares();
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
 /**
  * Memory pool.
  * Allocated memory blocks are kept until the pool is destructed.
+ * Blocks are taken from BlockAllocator, and each block is twice as large
+ * as the previous one up to the configured maximum.
  */
 class MemoryPool {
-    struct Unit {
+    union Unit {
         Unit* next;
+        size_t size;
     };
 
     static size_t const UNIT_SIZE = sizeof(Unit);
+    static size_t const HEADER_UNITS = 2; // next block and size in units
     static size_t const BLOCK_UNITS = 400000 / UNIT_SIZE;
-    static size_t const MAX_ELEMENT_UNIS = BLOCK_UNITS / 10;
 
     Unit* blockList;
     size_t nextUnit;
+    size_t blockUnits; ///< Size of the current block.
+
+    static Unit* newBlock(size_t units) {
+        Unit* block = static_cast<Unit*>(BlockAllocator::allocate(
+                units * UNIT_SIZE));
+        block[1].size = units;
+        return block;
+    }
+
+    static void deleteBlock(Unit* block) {
+        BlockAllocator::deallocate(block, block[1].size * UNIT_SIZE);
+    }
 
 public:
     MemoryPool()
-            : blockList(0), nextUnit(BLOCK_UNITS) {
+            : blockList(0), nextUnit(0), blockUnits(0) {
     }
 
     MemoryPool(MemoryPool const& o)
-            : blockList(0), nextUnit(BLOCK_UNITS) {
+            : blockList(0), nextUnit(0), blockUnits(0) {
 //        if (o.blockList != 0) throw std::runtime_error(
 //                "MemoryPool can't be copied unless it is empty!"); //FIXME
     }
@@ -80,7 +116,10 @@ public:
     void moveFrom(MemoryPool& o) {
         blockList = o.blockList;
         nextUnit = o.nextUnit;
+        blockUnits = o.blockUnits;
         o.blockList = 0;
+        o.nextUnit = 0;
+        o.blockUnits = 0;
     }
 
     virtual ~MemoryPool() {
@@ -95,9 +134,10 @@ public:
         while (blockList != 0) {
             Unit* block = blockList;
             blockList = blockList->next;
-            delete[] block;
+            deleteBlock(block);
         }
-        nextUnit = BLOCK_UNITS;
+        nextUnit = 0;
+        blockUnits = 0;
     }
 
     void reuse() {
@@ -105,9 +145,10 @@ public:
         while (blockList->next != 0) {
             Unit* block = blockList;
             blockList = blockList->next;
-            delete[] block;
+            deleteBlock(block);
         }
-        nextUnit = 1;
+        nextUnit = HEADER_UNITS;
+        blockUnits = blockList[1].size;
     }
 
     void splice(MemoryPool& o) {
@@ -121,34 +162,39 @@ public:
 
         blockList = o.blockList;
         nextUnit = o.nextUnit;
+        blockUnits = o.blockUnits;
 
         o.blockList = 0;
-        o.nextUnit = BLOCK_UNITS;
+        o.nextUnit = 0;
+        o.blockUnits = 0;
     }
 
     void* alloc(size_t n) {
         size_t const elementUnits = (n + UNIT_SIZE - 1) / UNIT_SIZE;
 
-        if (elementUnits > MAX_ELEMENT_UNIS) {
-            size_t m = elementUnits + 1;
-            Unit* block = new Unit[m];
+        if (elementUnits > BLOCK_UNITS / 10) {
+            Unit* block = newBlock(elementUnits + HEADER_UNITS);
             if (blockList == 0) {
                 block->next = 0;
-                blockList = block;
+                blockList = block; // full, and not to be grown from
             }
             else {
                 block->next = blockList->next;
                 blockList->next = block;
             }
-            return block + 1;
+            return block + HEADER_UNITS;
         }
 
-        if (nextUnit + elementUnits > BLOCK_UNITS) {
-            Unit* block = new Unit[BLOCK_UNITS];
+        if (nextUnit + elementUnits > blockUnits) {
+            size_t units = BlockAllocator::grow(blockUnits * UNIT_SIZE)
+                    / UNIT_SIZE;
+            if (units < BLOCK_UNITS) units = BLOCK_UNITS;
+            Unit* block = newBlock(units);
             block->next = blockList;
             blockList = block;
-            nextUnit = 1;
-            assert(nextUnit + elementUnits <= BLOCK_UNITS);
+            nextUnit = HEADER_UNITS;
+            blockUnits = block[1].size;
+            assert(nextUnit + elementUnits <= blockUnits);
         }
 
         Unit* p = blockList + nextUnit;
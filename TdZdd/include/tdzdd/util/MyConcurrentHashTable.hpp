@@ -0,0 +1,132 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <stdint.h>
+
+namespace tdzdd {
+
+/**
+ * Insert-only open-addressing hash table of non-null pointers
+ * shared by multiple threads.
+ * A new element is published by a CAS on an empty slot, so that concurrent
+ * add() calls never block each other.
+ * The capacity is a power of two and is fixed between resize() calls.
+ * @tparam T pointer type of the elements.
+ */
+template<typename T>
+class MyConcurrentHashTable {
+    std::atomic<T>* table;
+    size_t capacity;
+    int bits;
+
+    size_t home(size_t h) const {
+        return size_t((uint64_t(h) * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+    }
+
+public:
+    MyConcurrentHashTable() :
+            table(0), capacity(0), bits(0) {
+    }
+
+    MyConcurrentHashTable(MyConcurrentHashTable const& o) = delete;
+    MyConcurrentHashTable& operator=(MyConcurrentHashTable const& o) = delete;
+
+    ~MyConcurrentHashTable() {
+        delete[] table;
+    }
+
+    /**
+     * Makes room for n elements at the load factor of 50% or less.
+     * The slots are not cleared; see clear(size_t, size_t).
+     * Not thread-safe.
+     * @param n the maximum number of elements.
+     */
+    void resize(size_t n) {
+        int b = 4;
+        while ((size_t(1) << b) < n * 2) ++b;
+        if (b == bits) return;
+        delete[] table;
+        bits = b;
+        capacity = size_t(1) << b;
+        table = new std::atomic<T>[capacity];
+    }
+
+    /**
+     * Returns the number of slots.
+     * @return the number of slots.
+     */
+    size_t tableSize() const {
+        return capacity;
+    }
+
+    /**
+     * Empties slots [from, to).
+     * Threads may clear disjoint ranges concurrently.
+     * @param from the first slot.
+     * @param to the end of the slots.
+     */
+    void clear(size_t from, size_t to) {
+        assert(to <= capacity);
+        for (size_t k = from; k < to; ++k) {
+            table[k].store(T(0), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Inserts an element unless an equivalent one exists.
+     * Thread-safe with respect to other add() calls.
+     * @param p the element.
+     * @param eh hash function and equality of the elements.
+     * @param inserted set to true if @p p is inserted.
+     * @return the element in the table, that is @p p itself when inserted.
+     */
+    template<typename EH>
+    T add(T p, EH const& eh, bool& inserted) {
+        assert(p != T(0));
+        size_t const mask = capacity - 1;
+
+        for (size_t k = home(eh(p));; k = (k + 1) & mask) {
+            T q = table[k].load(std::memory_order_acquire);
+            if (q == T(0)) {
+                if (table[k].compare_exchange_strong(q, p,
+                        std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    inserted = true;
+                    return p;
+                }
+                // lost the race; q is the winner of the slot
+            }
+            if (eh(q, p)) {
+                inserted = false;
+                return q;
+            }
+        }
+    }
+};
+
+} // namespace tdzdd
@@ -24,18 +24,28 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <stdexcept>
 
+#include "BlockAllocator.hpp"
+
 namespace tdzdd {
 
+/**
+ * List of variable-size elements that are stored in blocks.
+ * New blocks are taken from BlockAllocator; the first one has room for
+ * BLOCK_ELEMENTS elements and each following one is twice as large as the
+ * block in front up to the configured maximum.
+ */
 template<typename T, size_t BLOCK_ELEMENTS = 1000>
 class MyList {
-    static int const headerCells = 1;
+    static int const headerCells = 2; // block size and start of the front
 
-    struct Cell {
+    union Cell {
         Cell* next;
+        size_t size;
     };
 
     Cell* front_;
@@ -66,6 +76,17 @@ class MyList {
         return reinterpret_cast<T*>(p + 1);
     }
 
+    static Cell* newBlock(size_t m) {
+        Cell* block = static_cast<Cell*>(BlockAllocator::allocate(
+                m * sizeof(Cell)));
+        block[0].size = m;
+        return block;
+    }
+
+    static void deleteBlock(Cell* block) {
+        BlockAllocator::deallocate(block, block[0].size * sizeof(Cell));
+    }
+
 public:
     MyList()
             : front_(0), size_(0) {
@@ -127,7 +148,7 @@ public:
                 p = p->next;
             }
 
-            delete[] blockStart(front_);
+            deleteBlock(blockStart(front_));
             front_ = clearFlag(p);
         }
         size_ = 0;
@@ -160,10 +181,14 @@ public:
         size_t const n = numCells(numElements * sizeof(T)) + 1;
 
         if (front_ == 0 || front_ < blockStart(front_) + headerCells + n) {
-            size_t const m = headerCells + n * BLOCK_ELEMENTS;
-            Cell* newBlock = new Cell[m];
-            Cell* newFront = newBlock + m - n;
-            blockStart(newFront) = newBlock;
+            size_t m = headerCells + n * BLOCK_ELEMENTS;
+            if (front_ != 0) {
+                size_t const bytes = blockStart(front_)[0].size * sizeof(Cell);
+                m = std::max(m, BlockAllocator::grow(bytes) / sizeof(Cell));
+            }
+            Cell* block = newBlock(m);
+            Cell* newFront = block + m - n;
+            blockStart(newFront) = block;
             newFront->next = setFlag(front_);
             front_ = newFront;
         }
@@ -186,7 +211,7 @@ public:
         Cell* next = front_->next;
 
         if (flagged(next)) {
-            delete[] blockStart(front_);
+            deleteBlock(blockStart(front_));
             front_ = clearFlag(next);
         }
         else {
@@ -0,0 +1,280 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <stdint.h>
+
+#include "MyHashTable.hpp"
+
+namespace tdzdd {
+
+/**
+ * Unique table of pointers with power-of-two size.
+ * Each slot keeps the full hash code next to the pointer, so that a probe
+ * dereferences the element only when the hash codes are equal; the
+ * elements, such as spec states, are usually far away in memory.
+ * Hash codes are mixed, and the slot is taken from the lower bits
+ * instead of by a division.
+ * Elements cannot be removed.
+ * @param T pointer type of elements; the null pointer cannot be added.
+ */
+template<typename T, typename Hash = MyHashDefault<T>,
+        typename Equal = MyHashDefault<T> >
+class MyUniqueTable {
+public:
+    /// Suggested distance in elements between prefetch(code) and add.
+    static int const PREFETCH_DISTANCE = 8;
+
+private:
+    static int const MAX_FILL = 75;
+
+    struct Slot {
+        size_t hash;
+        T ptr;
+    };
+
+    Hash const hashFunc;   ///< Functor for getting hash codes.
+    Equal const eqFunc;    ///< Functor for checking equivalence.
+
+    size_t capacity_;      ///< Size of the storage.
+    size_t tableSize_;     ///< Size of the hash table.
+    size_t maxSize_;       ///< The maximum number of elements.
+    size_t size_;          ///< The number of elements.
+    Slot* table;           ///< Pointer to the storage.
+
+    /*
+     * Spreads a hash code given by the hash function over all bits
+     * (MurmurHash3 finalizer); the codes of the specs are sums or products
+     * that are not mixed enough for taking the lower bits.
+     */
+    static size_t mix(size_t h) {
+        uint64_t x = h;
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        x ^= x >> 33;
+        return size_t(x);
+    }
+
+    // returns the first empty slot from the home of mixed hash code h
+    size_t findEmpty(size_t h) const {
+        size_t const mask = tableSize_ - 1;
+        size_t k = h & mask;
+        while (table[k].ptr != T()) {
+            k = (k + 1) & mask;
+        }
+        return k;
+    }
+
+    void grow() {
+        size_t const oldSize = tableSize_;
+        Slot* const oldTable = table;
+
+        table = 0;
+        capacity_ = 0;
+        initialize(size_ * 2 + 1);
+
+        for (size_t k = 0; k < oldSize; ++k) {
+            if (oldTable[k].ptr != T()) {
+                table[findEmpty(oldTable[k].hash)] = oldTable[k];
+                ++size_;
+            }
+        }
+
+        delete[] oldTable;
+    }
+
+public:
+    /**
+     * Default constructor.
+     */
+    MyUniqueTable(Hash const& hash = Hash(), Equal const& equal = Equal())
+            : hashFunc(hash), eqFunc(equal), capacity_(0), tableSize_(0),
+              maxSize_(0), size_(0), table(0) {
+    }
+
+    /**
+     * Constructor.
+     * @param n the number of elements to hold without rehashing.
+     * @param hash hash function.
+     * @param equal equality function
+     */
+    MyUniqueTable(size_t n, Hash const& hash = Hash(), Equal const& equal =
+            Equal())
+            : hashFunc(hash), eqFunc(equal), capacity_(0), tableSize_(0),
+              maxSize_(0), size_(0), table(0) {
+        initialize(n);
+    }
+
+    /**
+     * Copy constructor.
+     * @param o object to be copied.
+     */
+    MyUniqueTable(MyUniqueTable const& o)
+            : hashFunc(o.hashFunc), eqFunc(o.eqFunc), capacity_(0),
+              tableSize_(0), maxSize_(0), size_(0), table(0) {
+        *this = o;
+    }
+
+    MyUniqueTable& operator=(MyUniqueTable const& o) {
+        if (this == &o) return *this;
+        clear();
+        if (o.tableSize_ == 0) return *this;
+
+        capacity_ = tableSize_ = o.tableSize_;
+        maxSize_ = o.maxSize_;
+        size_ = o.size_;
+        table = new Slot[tableSize_];
+        for (size_t k = 0; k < tableSize_; ++k) {
+            table[k] = o.table[k];
+        }
+        return *this;
+    }
+
+    ~MyUniqueTable() {
+        delete[] table;
+    }
+
+    size_t tableSize() const {
+        return tableSize_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * Initialize the table to be empty.
+     * The memory is deallocated.
+     */
+    void clear() {
+        delete[] table;
+        capacity_ = 0;
+        tableSize_ = 0;
+        maxSize_ = 0;
+        size_ = 0;
+        table = 0;
+    }
+
+    /**
+     * Initialize the table to be empty.
+     * The storage is reused if it is large enough.
+     * @param n the number of elements to hold without rehashing.
+     */
+    void initialize(size_t n) {
+        size_t m = 16;
+        while (m * MAX_FILL / 100 < n) {
+            m <<= 1;
+        }
+
+        tableSize_ = m;
+        maxSize_ = m * MAX_FILL / 100;
+        size_ = 0;
+
+        if (capacity_ < m) {
+            delete[] table;
+            capacity_ = m;
+            table = new Slot[m];
+        }
+        for (size_t k = 0; k < m; ++k) {
+            table[k].ptr = T();
+        }
+    }
+
+    /**
+     * Insert an element if no other equivalent element is registered.
+     * @param elem the element to be inserted.
+     * @return reference to the element in the table.
+     */
+    T& add(T elem) {
+        return add(elem, hashFunc(elem));
+    }
+
+    /**
+     * Insert an element if no other equivalent element is registered.
+     * @param elem the element to be inserted.
+     * @param code the hash code of @p elem given by the hash function.
+     * @return reference to the element in the table.
+     */
+    T& add(T elem, size_t code) {
+        assert(elem != T());
+        if (size_ >= maxSize_) grow();
+        size_t const h = mix(code);
+        size_t const mask = tableSize_ - 1;
+        size_t k = h & mask;
+
+        while (table[k].ptr != T()) {
+            if (table[k].hash == h && eqFunc(table[k].ptr, elem)) {
+                return table[k].ptr;
+            }
+            k = (k + 1) & mask;
+        }
+
+        ++size_;
+        table[k].hash = h;
+        table[k].ptr = elem;
+        return table[k].ptr;
+    }
+
+    /**
+     * Prefetches the home slot of a hash code.
+     * Calling it some elements ahead of add(elem, code) hides the latency
+     * of the slot access when the table is much larger than the cache;
+     * the table must not grow in between.
+     * @param code the hash code given by the hash function.
+     */
+    void prefetch(size_t code) const {
+        if (tableSize_ == 0) return;
+        __builtin_prefetch(&table[mix(code) & (tableSize_ - 1)]);
+    }
+
+    /**
+     * Get the element that is already registered.
+     * @param elem the element to be searched.
+     * @return pointer to the element in the table or null.
+     */
+    T* get(T elem) const {
+        assert(elem != T());
+        if (tableSize_ == 0) return 0;
+        size_t const h = mix(hashFunc(elem));
+        size_t const mask = tableSize_ - 1;
+
+        for (size_t k = h & mask; table[k].ptr != T(); k = (k + 1) & mask) {
+            if (table[k].hash == h && eqFunc(table[k].ptr, elem)) {
+                return &table[k].ptr;
+            }
+        }
+        return 0;
+    }
+};
+
+} // namespace tdzdd
@@ -26,10 +26,19 @@
 
 #include <cassert>
 #include <cstring>
+#include <memory>
 #include <vector>
 
 namespace tdzdd {
 
+/**
+ * Allocator of MyVector, which can be specialized for an element type.
+ * @tparam T element type.
+ */
+template<typename T>
+struct MyVectorAllocator: std::allocator<T> {
+};
+
 template<typename T, typename Size = size_t>
 class MyVector {
     Size capacity_;  ///< Size of the array.
@@ -37,11 +46,11 @@ class MyVector {
     T* array_;         ///< Start address of the array.
 
     static T* allocate(Size n) {
-        return std::allocator<T>().allocate(n);
+        return MyVectorAllocator<T>().allocate(n);
     }
 
     static void deallocate(T* p, Size n) {
-        std::allocator<T>().deallocate(p, n);
+        MyVectorAllocator<T>().deallocate(p, n);
     }
 
     void ensureCapacity(Size capacity) {
@@ -0,0 +1,203 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+namespace tdzdd {
+
+/**
+ * Array element type of @p BITS bits for POD array specs.
+ * PodArrayDdSpec and PodHybridDdSpec store such elements packed
+ * in words and pass them to the spec as PackedArray<BITS>,
+ * or as PackedConstArray<BITS> where they are read only.
+ * @tparam BITS the number of bits of an element.
+ */
+template<int BITS>
+struct PackedBits {
+};
+
+template<int BITS>
+class PackedConstArray;
+
+/**
+ * Array of signed integers of @p BITS bits packed in words.
+ * This is a view on memory owned by someone else, like a pointer.
+ * Fields never straddle words; the spare bits of a word stay zero
+ * so that arrays can be hashed and compared word by word.
+ * @tparam BITS the number of bits of an element (2 to 31).
+ */
+template<int BITS>
+class PackedArray {
+    static_assert(2 <= BITS && BITS <= 31, "PackedArray needs 2 to 31 bits");
+
+public:
+    typedef size_t Word;
+
+    static int const FIELDS = sizeof(Word) * 8 / BITS; ///< Elements per word.
+    static int const MIN_VALUE = -(1 << (BITS - 1));
+    static int const MAX_VALUE = (1 << (BITS - 1)) - 1;
+
+    /**
+     * Returns the number of words for an array.
+     * @param n the number of elements.
+     * @return the number of words.
+     */
+    static int words(int n) {
+        return (n + FIELDS - 1) / FIELDS;
+    }
+
+private:
+    static Word const MASK = (Word(1) << BITS) - 1;
+    static Word const SIGN = Word(1) << (BITS - 1);
+
+    static int get(Word w, int shift) {
+        return int(((w >> shift) & MASK) ^ SIGN) - int(SIGN);
+    }
+
+    Word* p;
+
+    friend class PackedConstArray<BITS>;
+
+public:
+    /**
+     * Reference to an element.
+     */
+    class Ref {
+        Word& w;
+        int shift;
+
+    public:
+        Ref(Word& w, int shift) :
+                w(w), shift(shift) {
+        }
+
+        operator int() const {
+            return get(w, shift);
+        }
+
+        Ref& operator=(int v) {
+            assert(MIN_VALUE <= v && v <= MAX_VALUE);
+            w = (w & ~(MASK << shift)) | ((Word(v) & MASK) << shift);
+            return *this;
+        }
+
+        Ref& operator=(Ref const& o) {
+            return *this = int(o);
+        }
+
+        Ref& operator++() {
+            return *this = int(*this) + 1;
+        }
+
+        Ref& operator--() {
+            return *this = int(*this) - 1;
+        }
+    };
+
+    explicit PackedArray(void* p) :
+            p(static_cast<Word*>(p)) {
+    }
+
+    Ref operator[](size_t i) const {
+        return Ref(p[i / FIELDS], int(i % FIELDS) * BITS);
+    }
+
+    operator PackedConstArray<BITS>() const {
+        return PackedConstArray<BITS>(p);
+    }
+};
+
+/**
+ * Read-only view of a PackedArray.
+ * @tparam BITS the number of bits of an element (2 to 31).
+ */
+template<int BITS>
+class PackedConstArray {
+    typedef PackedArray<BITS> Array;
+    typedef typename Array::Word Word;
+
+    Word const* p;
+
+public:
+    explicit PackedConstArray(void const* p) :
+            p(static_cast<Word const*>(p)) {
+    }
+
+    int operator[](size_t i) const {
+        return Array::get(p[i / Array::FIELDS],
+                int(i % Array::FIELDS) * BITS);
+    }
+};
+
+/**
+ * How POD array specs see an array of element type @p T in a state:
+ * as T* by default, and as PackedArray<BITS> for PackedBits<BITS>.
+ * ConstArray is the read-only counterpart.
+ * @tparam T data type of array elements.
+ */
+template<typename T>
+struct ArrayView {
+    typedef size_t Word;
+    typedef T State;
+    typedef T* Array;
+    typedef T const* ConstArray;
+    typedef T& Ref;
+
+    static int words(int n) {
+        return (n * sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+    }
+
+    static Array array(void* p) {
+        return static_cast<T*>(p);
+    }
+
+    static ConstArray array(void const* p) {
+        return static_cast<T const*>(p);
+    }
+};
+
+template<int BITS>
+struct ArrayView<PackedBits<BITS> > {
+    typedef int State;
+    typedef PackedArray<BITS> Array;
+    typedef PackedConstArray<BITS> ConstArray;
+    typedef typename Array::Ref Ref;
+
+    static int words(int n) {
+        return Array::words(n);
+    }
+
+    static Array array(void* p) {
+        return Array(p);
+    }
+
+    static ConstArray array(void const* p) {
+        return ConstArray(p);
+    }
+};
+
+} // namespace tdzdd
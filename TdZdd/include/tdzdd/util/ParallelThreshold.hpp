@@ -0,0 +1,158 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "MyHashTable.hpp"
+
+namespace tdzdd {
+
+/**
+ * Level width from which multi-threaded algorithms run a level in parallel.
+ * Narrower levels are processed by one thread, because forking and joining
+ * a thread team costs more than the work itself.
+ */
+class ParallelThreshold {
+    static int const BARRIERS = 8;    ///< Barriers per level (about).
+    static size_t const MIN_WIDTH = 64;
+    static size_t const MAX_WIDTH = size_t(1) << 20;
+
+    /**
+     * Compares the cost of a thread team with one barrier against
+     * the cost of inserting a key into a hash table.
+     */
+    static size_t calibrate() {
+#ifdef _OPENMP
+        int const R = 64;
+#pragma omp parallel
+        {
+        } // starts the thread pool
+        double t0 = omp_get_wtime();
+        for (int r = 0; r < R; ++r) {
+#pragma omp parallel
+            {
+#pragma omp barrier
+            }
+        }
+        double const team = (omp_get_wtime() - t0) / R;
+
+        size_t const N = 1 << 14;
+        MyHashTable<size_t> uniq(N);
+        t0 = omp_get_wtime();
+        for (size_t k = 1; k <= N; ++k) {
+            uniq.add((uint64_t(k) * 0x9E3779B97F4A7C15ULL) | 1);
+        }
+        double const node = (omp_get_wtime() - t0) / N;
+
+        double w = node > 0 ? team * BARRIERS / node : MAX_WIDTH;
+        if (w < MIN_WIDTH) return MIN_WIDTH;
+        if (w > MAX_WIDTH) return MAX_WIDTH;
+        return size_t(w);
+#else
+        return size_t(-1);
+#endif
+    }
+
+    // the threshold, and whether it is given or calibrated yet
+    struct Setting {
+        size_t width;
+        bool known;
+    };
+
+    static Setting initialSetting() {
+        Setting t = {size_t(-1), false};
+        char const* s = std::getenv("TDZDD_MP_THRESHOLD");
+        if (s != 0 && *s != '\0') {
+            t.width = std::strtoull(s, 0, 10);
+            t.known = true;
+        }
+        return t;
+    }
+
+    static Setting& setting() {
+        static Setting s = initialSetting();
+        return s;
+    }
+
+    static bool multiThreaded() {
+#ifdef _OPENMP
+        return omp_get_max_threads() >= 2;
+#else
+        return false;
+#endif
+    }
+
+public:
+    /**
+     * Gets the threshold.
+     * Unless TDZDD_MP_THRESHOLD or set(size_t) gives it, it is calibrated
+     * at the first call that finds more than one thread available;
+     * until then every level is narrow.
+     * @return the minimum width of a parallel level.
+     */
+    static size_t value() {
+        Setting& s = setting();
+        if (!s.known && multiThreaded()) {
+            s.width = calibrate();
+            s.known = true;
+        }
+        return s.known ? s.width : size_t(-1);
+    }
+
+    /**
+     * Sets the threshold.
+     * @param width the minimum width of a parallel level; 0 makes every
+     *        level parallel.
+     */
+    static void set(size_t width) {
+        setting().width = width;
+        setting().known = true;
+    }
+
+    /**
+     * Forgets the threshold given by set(size_t) or calibrated so far.
+     */
+    static void reset() {
+        setting() = initialSetting();
+    }
+
+    /**
+     * Checks if a level should run in parallel.
+     * @param width the number of nodes in the level.
+     * @return true if @p width reaches the threshold.
+     */
+    static bool wide(size_t width) {
+        return width >= value();
+    }
+};
+
+} // namespace tdzdd
@@ -0,0 +1,173 @@
+/*
+ * TdZdd: a Top-down/Breadth-first Decision Diagram Manipulation Framework
+ * by Hiroaki Iwashita <iwashita@erato.ist.hokudai.ac.jp>
+ * Copyright (c) 2014 ERATO MINATO Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+#if defined(__SSE2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace tdzdd {
+
+/**
+ * Hashing and comparison of word arrays, such as POD array states.
+ * The instruction set is chosen at compile time (AVX2, SSE2 or none).
+ */
+struct WordArray {
+    typedef size_t Word;
+
+    // shortest arrays for vector code; a short scalar loop is faster,
+    // and a scalar comparison stops at the first different word
+#if defined(__AVX2__)
+    static int const NH_WORDS = 8;
+    static int const CMP_WORDS = 8;
+#elif defined(__SSE2__) && defined(__x86_64__)
+    static int const NH_WORDS = 4;
+    static int const CMP_WORDS = 16;
+#else
+    static int const NH_WORDS = 1 << 30;
+    static int const CMP_WORDS = 1 << 30;
+#endif
+
+    /* NH hashing (as in UMAC): each word is split into 32-bit halves (a, b),
+     * which are offset by position-dependent keys and multiplied as
+     * (a + ka) * (b + kb) in 64 bits, and the products are summed.
+     * The words are independent of each other, unlike in the
+     * multiply-accumulate chain for short arrays, so that 2 or 4 of them
+     * go in one vector multiplication (pmuludq).
+     * The tables reduce hash codes modulo a prime or by a multiplicative
+     * hash, so the sum is not mixed any further.
+     */
+    static uint32_t const KA = 0x9E3779B9U;
+    static uint32_t const KB = 0x85EBCA6BU;
+
+    static uint64_t nhWord(uint64_t w, uint32_t i) {
+        uint32_t a = uint32_t(w) + KA * (i + 1);
+        uint32_t b = uint32_t(w >> 32) + KB * (i + 1);
+        return uint64_t(a) * b;
+    }
+
+    static size_t nh(Word const* p, int n) {
+        int i = 0;
+        uint64_t sum = 0;
+#if defined(__AVX2__)
+        __m256i s = _mm256_setzero_si256();
+        __m256i k = _mm256_setr_epi32(KA, KB, 2 * KA, 2 * KB, 3 * KA, 3 * KB,
+                4 * KA, 4 * KB);
+        __m256i const dk = _mm256_setr_epi32(4 * KA, 4 * KB, 4 * KA, 4 * KB,
+                4 * KA, 4 * KB, 4 * KA, 4 * KB);
+        for (; i + 4 <= n; i += 4) {
+            __m256i w = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(p + i));
+            __m256i ab = _mm256_add_epi32(w, k);
+            s = _mm256_add_epi64(s,
+                    _mm256_mul_epu32(ab, _mm256_srli_epi64(ab, 32)));
+            k = _mm256_add_epi32(k, dk);
+        }
+        __m128i t = _mm_add_epi64(_mm256_castsi256_si128(s),
+                _mm256_extracti128_si256(s, 1));
+        sum = uint64_t(_mm_cvtsi128_si64(t))
+                + uint64_t(_mm_cvtsi128_si64(_mm_unpackhi_epi64(t, t)));
+#elif defined(__SSE2__) && defined(__x86_64__)
+        __m128i s = _mm_setzero_si128();
+        __m128i k = _mm_setr_epi32(KA, KB, 2 * KA, 2 * KB);
+        __m128i const dk = _mm_setr_epi32(2 * KA, 2 * KB, 2 * KA, 2 * KB);
+        for (; i + 2 <= n; i += 2) {
+            __m128i w = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+            __m128i ab = _mm_add_epi32(w, k);
+            s = _mm_add_epi64(s, _mm_mul_epu32(ab, _mm_srli_epi64(ab, 32)));
+            k = _mm_add_epi32(k, dk);
+        }
+        sum = uint64_t(_mm_cvtsi128_si64(s))
+                + uint64_t(_mm_cvtsi128_si64(_mm_unpackhi_epi64(s, s)));
+#endif
+        for (; i < n; ++i) {
+            sum += nhWord(p[i], i);
+        }
+        return size_t(sum);
+    }
+
+    /**
+     * Computes the hash code of an array.
+     * Arrays shorter than NH_WORDS use a multiply-accumulate chain,
+     * which is faster than setting up vector lanes for a few words.
+     * @param p the array.
+     * @param n the number of words.
+     * @param h initial value, such as the hash code of a scalar state.
+     * @return the hash code.
+     */
+    static size_t hash(Word const* p, int n, size_t h = 0) {
+        if (n >= NH_WORDS) {
+            return nh(p, n) + h * 0xFF51AFD7ED558CCDULL;
+        }
+        for (int i = 0; i < n; ++i) {
+            h += p[i];
+            h *= 314159257;
+        }
+        return h;
+    }
+
+    /**
+     * Compares two arrays.
+     * @param p an array.
+     * @param q another array.
+     * @param n the number of words.
+     * @return true if they are equal.
+     */
+    static bool equal(Word const* p, Word const* q, int n) {
+        int i = 0;
+        if (n < CMP_WORDS) {
+            for (; i < n; ++i) {
+                if (p[i] != q[i]) return false;
+            }
+            return true;
+        }
+#if defined(__AVX2__)
+        for (; i + 4 <= n; i += 4) {
+            __m256i a = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(p + i));
+            __m256i b = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(q + i));
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != -1)
+                return false;
+        }
+#endif
+#if defined(__SSE2__) && defined(__x86_64__)
+        for (; i + 2 <= n; i += 2) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(q + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) return false;
+        }
+#endif
+        for (; i < n; ++i) {
+            if (p[i] != q[i]) return false;
+        }
+        return true;
+    }
+};
+
+} // namespace tdzdd